@@ -0,0 +1,94 @@
+/*! \file batch.cpp
+	\brief Runs independent jobs on all cores
+
+	\author agent
+	\version 20261016
+
+	Changelog:
+		- 20261016 agent
+			- initial version
+*/
+#include <exception>
+#include <thread>
+#include "batch.h"
+
+namespace sim {
+
+//! \brief Creates a pool, 0 threads means one per core
+Pool::Pool (int threads)
+	: nthreads(threads > 0 ? threads : (int)std::thread::hardware_concurrency()),
+	  queues(nthreads > 0 ? nthreads : 1)
+{
+	if (nthreads < 1) nthreads = 1;
+}
+// Pool
+
+/*!
+	\brief Runs fn for jobs 0 to jobs-1 and waits for all of them
+
+	fn is called concurrently from all workers. The first exception
+	thrown by a job is rethrown after all workers are done.
+*/
+void Pool::run (size_t jobs, const std::function<void(size_t)> &fn)
+{
+	for (size_t j = 0; j < jobs; j++) queues[j % nthreads].jobs.push_back(j);
+	std::exception_ptr error;
+	std::mutex lock;
+	std::function<void(size_t)> guarded = [&](size_t job) {
+		try {
+			fn(job);
+		} catch (...) {
+			std::lock_guard<std::mutex> g(lock);
+			if (!error) error = std::current_exception();
+		}
+	};
+	std::vector<std::thread> workers;
+	for (int t = 1; t < nthreads; t++)
+		workers.push_back(std::thread(&Pool::work, this, (size_t)t, std::cref(guarded)));
+	work(0, guarded);
+	for (size_t t = 0; t < workers.size(); t++) workers[t].join();
+	if (error) std::rethrow_exception(error);
+}
+// run
+
+//! \brief Worker loop, runs jobs until all queues are empty
+void Pool::work (size_t self, const std::function<void(size_t)> &fn)
+{
+	size_t job;
+	while (take(self, job)) fn(job);
+}
+// work
+
+/*!
+	\brief Takes the next job
+
+	The lowest job of the own queue, else the highest job of the
+	first other queue that has one.
+
+	\return	false if all queues are empty
+*/
+bool Pool::take (size_t self, size_t &job)
+{
+	{
+		Queue &q = queues[self];
+		std::lock_guard<std::mutex> g(q.lock);
+		if (!q.jobs.empty()) {
+			job = q.jobs.front();
+			q.jobs.pop_front();
+			return true;
+		}
+	}
+	for (size_t k = 1; k < queues.size(); k++) {
+		Queue &q = queues[(self + k) % queues.size()];
+		std::lock_guard<std::mutex> g(q.lock);
+		if (!q.jobs.empty()) {
+			job = q.jobs.back();
+			q.jobs.pop_back();
+			return true;
+		}
+	}
+	return false;
+}
+// take
+
+} // namespace sim
@@ -0,0 +1,55 @@
+/*! \file batch.h
+	\brief Runs independent jobs on all cores
+
+	A pool of worker threads with one job queue each. The jobs are
+	dealt round robin to the queues. A worker takes the lowest job
+	of its own queue. When its queue is empty it steals the highest
+	job of another queue, such that long jobs do not leave the other
+	workers idle.
+
+	Simulations are independent of the thread they run on, since every
+	run has its own Runtime and program instance. A batch therefore
+	gives the same results for any number of threads.
+
+	\author agent
+	\version 20261016
+
+	Changelog:
+		- 20261016 agent
+			- initial version
+*/
+#ifndef SIM_BATCH_H
+#define SIM_BATCH_H 1
+
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+namespace sim {
+
+/*!
+	\brief Work stealing thread pool
+*/
+class Pool
+{
+public:
+	explicit Pool (int threads = 0);
+	int threads (void) const { return nthreads; }
+	void run (size_t jobs, const std::function<void(size_t)> &fn);
+
+private:
+	struct Queue {
+		std::mutex lock;              //!< protects jobs
+		std::deque<size_t> jobs;      //!< job numbers, lowest first
+	};
+	void work (size_t self, const std::function<void(size_t)> &fn);
+	bool take (size_t self, size_t &job);
+
+	int nthreads;                     //!< number of workers
+	std::vector<Queue> queues;        //!< one queue per worker
+};
+
+} // namespace sim
+
+#endif // SIM_BATCH_H
@@ -0,0 +1,212 @@
+/*! \file flash.cpp
+	\brief Flash file system of the simulated NXT brick
+
+	Flash images, as written by save, little endian:
+
+		0   char[4]   magic "NXF1"
+		then per file:
+		    uint8     length of the name
+		    char[]    name
+		    uint32    size of the file
+		    uint32    length of the data
+		    uint8[]   data
+
+	\author agent
+	\version 20261016
+
+	Changelog:
+		- 20261016 agent
+			- initial version
+*/
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include "flash.h"
+
+namespace sim {
+
+#define NXF_MAGIC    "NXF1"    //!< magic number of flash images
+
+//! \brief Reads a little endian uint32
+static unsigned long get32 (std::istream &in)
+{
+	unsigned char p[4] = { 0, 0, 0, 0 };
+	in.read((char *)p, 4);
+	return p[0] | (p[1] << 8) | (p[2] << 16) | ((unsigned long)p[3] << 24);
+}
+// get32
+
+//! \brief Writes a little endian uint32
+static void put32 (std::ostream &out, unsigned long v)
+{
+	unsigned char p[4] = { (unsigned char)v, (unsigned char)(v >> 8), (unsigned char)(v >> 16), (unsigned char)(v >> 24) };
+	out.write((const char *)p, 4);
+}
+// put32
+
+Flash::Flash (void)
+{
+	close_all();
+}
+
+//! \brief Opens a file for writing or reading, the handle is -1 on errors
+unsigned int Flash::open (const std::string &name, bool write, int &handle)
+{
+	handle = -1;
+	for (int h = 0; h < FLASH_HANDLES; h++) {
+		if (!handles[h].name.empty()) continue;
+		handles[h].name = name;
+		handles[h].write = write;
+		handles[h].pos = 0;
+		handle = h;
+		return LDR_SUCCESS;
+	}
+	return LDR_NOMOREHANDLES;
+}
+// open
+
+/*!
+	\brief Creates a file of size bytes and opens it for writing
+*/
+unsigned int Flash::create (const std::string &name, unsigned int size, int &handle)
+{
+	handle = -1;
+	if (files.count(name)) return LDR_FILEEXISTS;
+	unsigned long used = 0;
+	for (std::map<std::string, File>::const_iterator i = files.begin(); i != files.end(); ++i) used += i->second.size;
+	if (used + size > FLASH_SIZE) return LDR_NOSPACE;
+	unsigned int rc = open(name, true, handle);
+	if (rc != LDR_SUCCESS) return rc;
+	files[name].size = size;
+	return LDR_SUCCESS;
+}
+// create
+
+/*!
+	\brief Opens a file for writing after its data
+
+	Like the firmware, size is set to the space left in the file.
+*/
+unsigned int Flash::append (const std::string &name, unsigned int &size, int &handle)
+{
+	handle = -1;
+	std::map<std::string, File>::const_iterator f = files.find(name);
+	if (f == files.end()) return LDR_FILENOTFOUND;
+	size = f->second.size - (unsigned int)f->second.data.size();
+	if (size == 0) return LDR_FILEISFULL;
+	return open(name, true, handle);
+}
+// append
+
+//! \brief Opens a file for reading, size is set to the length of its data
+unsigned int Flash::read (const std::string &name, unsigned int &size, int &handle)
+{
+	handle = -1;
+	std::map<std::string, File>::const_iterator f = files.find(name);
+	if (f == files.end()) return LDR_FILENOTFOUND;
+	size = (unsigned int)f->second.data.size();
+	return open(name, false, handle);
+}
+// read
+
+unsigned int Flash::close (int handle)
+{
+	if ((handle < 0) || (handle >= FLASH_HANDLES) || handles[handle].name.empty()) return LDR_HANDLEALREADYCLOSED;
+	handles[handle].name.clear();
+	return LDR_SUCCESS;
+}
+// close
+
+//! \brief Reads the next byte of a file opened for reading
+unsigned int Flash::get (int handle, unsigned char &value)
+{
+	if ((handle < 0) || (handle >= FLASH_HANDLES) || handles[handle].name.empty()) return LDR_HANDLEALREADYCLOSED;
+	Handle &h = handles[handle];
+	const File &f = files[h.name];
+	if (h.write || (h.pos >= f.data.size())) return LDR_ENDOFFILE;
+	value = f.data[h.pos++];
+	return LDR_SUCCESS;
+}
+// get
+
+//! \brief Appends a byte to a file opened for writing
+unsigned int Flash::put (int handle, unsigned char value)
+{
+	if ((handle < 0) || (handle >= FLASH_HANDLES) || handles[handle].name.empty()) return LDR_HANDLEALREADYCLOSED;
+	Handle &h = handles[handle];
+	File &f = files[h.name];
+	if (!h.write || (f.data.size() >= f.size)) return LDR_EOFEXPECTED;
+	f.data.push_back(value);
+	return LDR_SUCCESS;
+}
+// put
+
+//! \brief Closes all handles, like switching the brick off
+void Flash::close_all (void)
+{
+	for (int h = 0; h < FLASH_HANDLES; h++) handles[h].name.clear();
+}
+// close_all
+
+//! \brief Deletes a file, false if there is none
+bool Flash::remove (const std::string &name)
+{
+	return files.erase(name) > 0;
+}
+// remove
+
+bool Flash::exists (const std::string &name) const
+{
+	return files.count(name) > 0;
+}
+// exists
+
+//! \brief The data of a file, empty if there is none
+std::vector<unsigned char> Flash::data (const std::string &name) const
+{
+	std::map<std::string, File>::const_iterator f = files.find(name);
+	if (f == files.end()) return std::vector<unsigned char>();
+	return f->second.data;
+}
+// data
+
+//! \brief Loads the files from a flash image, replacing all files
+void Flash::load (const std::string &path)
+{
+	std::ifstream in(path.c_str(), std::ios::binary);
+	if (!in) throw std::runtime_error(path + ": cannot open");
+	char magic[4];
+	if (!in.read(magic, 4) || (std::string(magic, 4) != NXF_MAGIC)) throw std::runtime_error(path + ": not a flash image");
+	files.clear();
+	close_all();
+	int len;
+	while ((len = in.get()) != EOF) {
+		std::string name(len, ' ');
+		in.read(&name[0], len);
+		File &f = files[name];
+		f.size = get32(in);
+		f.data.resize(get32(in));
+		if (!f.data.empty()) in.read((char *)&f.data[0], f.data.size());
+		if (!in || (f.data.size() > f.size)) throw std::runtime_error(path + ": truncated flash image");
+	}
+}
+// load
+
+//! \brief Saves all files to a flash image
+void Flash::save (const std::string &path) const
+{
+	std::ofstream out(path.c_str(), std::ios::binary | std::ios::trunc);
+	if (!out) throw std::runtime_error(path + ": cannot create");
+	out.write(NXF_MAGIC, 4);
+	for (std::map<std::string, File>::const_iterator i = files.begin(); i != files.end(); ++i) {
+		out.put((char)i->first.size());
+		out.write(i->first.data(), i->first.size());
+		put32(out, i->second.size);
+		put32(out, i->second.data.size());
+		if (!i->second.data.empty()) out.write((const char *)&i->second.data[0], i->second.data.size());
+	}
+	if (!out) throw std::runtime_error(path + ": write error");
+}
+// save
+
+} // namespace sim
@@ -0,0 +1,82 @@
+/*! \file flash.h
+	\brief Flash file system of the simulated NXT brick
+
+	Files of the brick, like the loader module of the firmware keeps
+	them in flash. A file has the size it was created with and the
+	data written so far. Reading stops at the end of the data,
+	appending at the end of the size.
+
+	The files survive a run, such that a Flash shared by several
+	runtimes works like a brick switched off and on again between
+	the runs. Handles are closed when a runtime ends.
+
+	\author agent
+	\version 20261016
+
+	Changelog:
+		- 20261016 agent
+			- initial version
+*/
+#ifndef SIM_FLASH_H
+#define SIM_FLASH_H 1
+
+#include <map>
+#include <string>
+#include <vector>
+
+// LOADER MODULE
+#define LDR_SUCCESS                0x0000    //!< no error
+#define LDR_NOMOREHANDLES          0x8100    //!< all handles in use
+#define LDR_NOSPACE                0x8200    //!< not enough flash
+#define LDR_EOFEXPECTED            0x8400    //!< write beyond the size of the file
+#define LDR_ENDOFFILE              0x8500    //!< read beyond the data of the file
+#define LDR_FILENOTFOUND           0x8700    //!< no such file
+#define LDR_HANDLEALREADYCLOSED    0x8800    //!< handle not open
+#define LDR_FILEISFULL             0x8E00    //!< no space left to append
+#define LDR_FILEEXISTS             0x8F00    //!< file already exists
+
+// LIMITS
+#define FLASH_HANDLES    16        //!< open files at a time
+#define FLASH_SIZE       65536     //!< bytes of flash for files
+
+namespace sim {
+
+/*!
+	\brief The files of a brick
+*/
+class Flash
+{
+public:
+	Flash (void);
+	unsigned int create (const std::string &name, unsigned int size, int &handle);
+	unsigned int append (const std::string &name, unsigned int &size, int &handle);
+	unsigned int read (const std::string &name, unsigned int &size, int &handle);
+	unsigned int close (int handle);
+	unsigned int get (int handle, unsigned char &value);
+	unsigned int put (int handle, unsigned char value);
+	void close_all (void);
+	bool remove (const std::string &name);
+	bool exists (const std::string &name) const;
+	std::vector<unsigned char> data (const std::string &name) const;
+	void load (const std::string &path);
+	void save (const std::string &path) const;
+
+private:
+	struct File {
+		unsigned int size;                 //!< bytes allocated
+		std::vector<unsigned char> data;   //!< bytes written
+	};
+	struct Handle {
+		std::string name;    //!< the file, empty if closed
+		bool write;          //!< open for writing
+		size_t pos;          //!< next byte read
+	};
+	unsigned int open (const std::string &name, bool write, int &handle);
+
+	std::map<std::string, File> files;    //!< files by name
+	Handle handles[FLASH_HANDLES];        //!< open files
+};
+
+} // namespace sim
+
+#endif // SIM_FLASH_H
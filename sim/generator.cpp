@@ -0,0 +1,259 @@
+/*! \file generator.cpp
+	\brief Maze generator and poster printer
+
+	\author agent
+	\version 20261016
+
+	Changelog:
+		- 20261016 agent
+			- initial version
+			- benchmark corpus
+			- trap mazes
+			- traps out of the benchmark corpus
+*/
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+#include "generator.h"
+
+namespace sim {
+
+#define PARENT_NONE    0x00    //!< junction not visited yet
+#define PARENT_ROOT    0x05    //!< first junction of the search
+#define PT_PER_MM      2.834646    //!< PDF points per mm
+
+/*!
+	\brief Generates a maze
+
+	\param type maze type
+	\param cols, rows size of the grid, at least two junctions
+	\param seed seed of the random numbers
+	\param loops probability in [0,1] of adding a line that closes a loop,
+		0 gives a perfect maze
+*/
+Maze generate (int type, int cols, int rows, unsigned long long seed, double loops)
+{
+	Maze maze(type, cols, rows);
+	if (cols * rows < 2) throw std::invalid_argument("maze needs two junctions");
+	Random rnd(seed);
+	// parent[i] is 1 + direction towards the parent junction
+	std::vector<unsigned char> parent((size_t)cols * rows, PARENT_NONE);
+	int x = rnd.below(cols), y = rnd.below(rows);
+	parent[(size_t)y * cols + x] = PARENT_ROOT;
+	for (;;) {
+		int dirs[4], n = 0;
+		for (int d = DIR_EAST; d <= DIR_SOUTH; d++) {
+			int nx = x + Maze::dx(d), ny = y + Maze::dy(d);
+			if (maze.contains(nx, ny) && (parent[(size_t)ny * cols + nx] == PARENT_NONE)) dirs[n++] = d;
+		}
+		if (n) {
+			int d = dirs[rnd.below(n)];
+			maze.link(x, y, d);
+			x += Maze::dx(d);
+			y += Maze::dy(d);
+			parent[(size_t)y * cols + x] = 1 + ((d + 2) & 3);
+		} else {
+			int p = parent[(size_t)y * cols + x];
+			if (p == PARENT_ROOT) break;
+			x += Maze::dx(p - 1);
+			y += Maze::dy(p - 1);
+		}
+	}
+	if (loops > 0) {
+		for (y = 0; y < rows; y++)
+			for (x = 0; x < cols; x++) {
+				if ((x + 1 < cols) && !maze.linked(x, y, DIR_EAST) && (rnd.uniform() < loops))
+					maze.link(x, y, DIR_EAST);
+				if ((y + 1 < rows) && !maze.linked(x, y, DIR_NORTH) && (rnd.uniform() < loops))
+					maze.link(x, y, DIR_NORTH);
+			}
+	}
+	/*
+		start in the north eastern corner heading west if possible. The
+		outside is then on the right, the right hand follows the border
+		of the maze and gets to the exit in mazes with loops, too.
+	*/
+	x = cols - 1;
+	y = rows - 1;
+	maze.set_start(x, y, maze.linked(x, y, DIR_WEST) ? DIR_WEST : DIR_SOUTH);
+	// exit on a random side of the grid, off the start
+	for (;;) {
+		int d = rnd.below(4);
+		int i = rnd.below(((d == DIR_EAST) || (d == DIR_WEST)) ? rows : cols);
+		x = (d == DIR_EAST) ? cols - 1 : (d == DIR_WEST) ? 0 : i;
+		y = (d == DIR_NORTH) ? rows - 1 : (d == DIR_SOUTH) ? 0 : i;
+		if ((x == maze.start_x()) && (y == maze.start_y())) continue;
+		maze.set_exit(x, y, d);
+		break;
+	}
+	return maze;
+}
+// generate
+
+/*!
+	\brief Generates a maze the right hand rule never gets out of
+
+	A perfect maze of generate with a square of four lines added in
+	the middle and the start on its south western corner, heading
+	north. Going clockwise the square goes on to the right at each
+	corner, so the right hand rule circles it forever.
+
+	\param type maze type
+	\param cols, rows size of the grid, at least 4x4 junctions, such
+		that the square is off the border and the exit
+	\param seed seed of the random numbers
+*/
+Maze trap (int type, int cols, int rows, unsigned long long seed)
+{
+	if ((cols < 4) || (rows < 4)) throw std::invalid_argument("trap needs 4x4 junctions");
+	Maze maze = generate(type, cols, rows, seed, 0);
+	int x = cols / 2 - 1, y = rows / 2 - 1;
+	maze.link(x, y, DIR_NORTH);
+	maze.link(x, y + 1, DIR_EAST);
+	maze.link(x + 1, y, DIR_NORTH);
+	maze.link(x, y, DIR_EAST);
+	maze.set_start(x, y, DIR_NORTH);
+	return maze;
+}
+// trap
+
+//! \brief RGB color of a kind of surface in the PDF, as printed on the posters in etc/
+static const char *ink (int type, int kind)
+{
+	static const char *inks[3][KIND_COUNT] = {
+		{ "1 1 1", "0.6 0.6 0.6", "0 0 0", "0 0 0", "" },
+		{ "0.4 0.4 0.4", "1 1 1", "0 0 0", "0 0 0", "" },
+		{ "1 1 1", "0 0.588 0", "1 0 0", "0 0 1", "" }
+	};
+	return inks[type - MAZE_WHITE][kind];
+}
+// ink
+
+/*!
+	\brief Prints a maze poster as PDF
+
+	The page is 1 m by 1 m, such that mazes of up to 6x6 junctions
+	print on the usual posters. The grid is centered on the page and
+	the exit strip runs to the edge of the page. Larger mazes get a
+	larger page. Geometry is in mm, exactly like the simulated maze.
+*/
+void print_poster (const Maze &maze, const WorldMetrics &m, const std::string &path)
+{
+	double p = maze.pitch(m);
+	double w = std::max((double)POSTER_SIZE, maze.width(m));
+	double h = std::max((double)POSTER_SIZE, maze.height(m));
+	double ox = (w - maze.width(m)) / 2, oy = (h - maze.height(m)) / 2;
+	int type = maze.type();
+	std::ostringstream s;
+	s << PT_PER_MM << " 0 0 " << PT_PER_MM << " 0 0 cm\n";
+	s.setf(std::ios::fixed);
+	s.precision(2);
+	s << ink(type, KIND_BACKGROUND) << " rg 0 0 " << w << " " << h << " re f\n";
+	// lines first, junctions on top
+	s << ink(type, KIND_LINE) << " rg\n";
+	for (int y = 0; y < maze.rows(); y++)
+		for (int x = 0; x < maze.cols(); x++) {
+			double cx = ox + (x + 1) * p, cy = oy + (y + 1) * p;
+			if (maze.linked(x, y, DIR_EAST))
+				s << cx << " " << cy - m.wid_line / 2.0 << " " << p << " " << m.wid_line << " re\n";
+			if (maze.linked(x, y, DIR_NORTH))
+				s << cx - m.wid_line / 2.0 << " " << cy << " " << m.wid_line << " " << p << " re\n";
+		}
+	s << "f\n" << ink(type, KIND_JUNC) << " rg\n";
+	for (int y = 0; y < maze.rows(); y++)
+		for (int x = 0; x < maze.cols(); x++)
+			s << ox + (x + 1) * p - m.len_junc / 2.0 << " " << oy + (y + 1) * p - m.wid_junc / 2.0
+				<< " " << m.len_junc << " " << m.wid_junc << " re\n";
+	s << "f\n";
+	// exit strip from the junction to the edge of the page
+	double ex = ox + (maze.exit_x() + 1) * p, ey = oy + (maze.exit_y() + 1) * p;
+	double hw = m.wid_junc / 2.0;
+	s << ink(type, KIND_EXIT) << " rg ";
+	switch (maze.exit_dir()) {
+	case DIR_EAST: s << ex << " " << ey - hw << " " << w - ex << " " << m.wid_junc; break;
+	case DIR_NORTH: s << ex - hw << " " << ey << " " << m.wid_junc << " " << h - ey; break;
+	case DIR_WEST: s << 0.0 << " " << ey - hw << " " << ex << " " << m.wid_junc; break;
+	default: s << ex - hw << " " << 0.0 << " " << m.wid_junc << " " << ey; break;
+	}
+	s << " re f\n";
+	// start triangle half a pitch behind the start junction, pointing along the start heading
+	int dx = Maze::dx(maze.start_dir()), dy = Maze::dy(maze.start_dir());
+	double tx = ox + (maze.start_x() + 1) * p - dx * p / 2, ty = oy + (maze.start_y() + 1) * p - dy * p / 2;
+	double a = m.len_junc;
+	s << "0 0 0 rg " << tx + dx * a << " " << ty + dy * a << " m "
+		<< tx - dx * a / 2 - dy * a / 2 << " " << ty - dy * a / 2 + dx * a / 2 << " l "
+		<< tx - dx * a / 2 + dy * a / 2 << " " << ty - dy * a / 2 - dx * a / 2 << " l f\n";
+	std::string content = s.str();
+
+	// the document, objects are numbered 1 to 4
+	std::ostringstream box;
+	box.setf(std::ios::fixed);
+	box.precision(2);
+	box << "[0 0 " << w * PT_PER_MM << " " << h * PT_PER_MM << "]";
+	std::vector<std::string> objs;
+	objs.push_back("<< /Type /Catalog /Pages 2 0 R >>");
+	objs.push_back("<< /Type /Pages /Kids [3 0 R] /Count 1 >>");
+	objs.push_back("<< /Type /Page /Parent 2 0 R /MediaBox " + box.str() + " /Contents 4 0 R >>");
+	std::ostringstream len;
+	len << content.size();
+	objs.push_back("<< /Length " + len.str() + " >>\nstream\n" + content + "endstream");
+	std::ofstream out(path.c_str(), std::ios::binary | std::ios::trunc);
+	if (!out) throw std::runtime_error(path + ": cannot create");
+	out << "%PDF-1.4\n";
+	std::vector<long> offsets;
+	for (size_t i = 0; i < objs.size(); i++) {
+		offsets.push_back((long)out.tellp());
+		out << i + 1 << " 0 obj\n" << objs[i] << "\nendobj\n";
+	}
+	long xref = (long)out.tellp();
+	out << "xref\n0 " << objs.size() + 1 << "\n0000000000 65535 f \n";
+	for (size_t i = 0; i < offsets.size(); i++) {
+		char entry[24];
+		snprintf(entry, sizeof(entry), "%010ld 00000 n \n", offsets[i]);
+		out << entry;
+	}
+	out << "trailer\n<< /Size " << objs.size() + 1 << " /Root 1 0 R >>\nstartxref\n" << xref << "\n%%EOF\n";
+	if (!out) throw std::runtime_error(path + ": write error");
+}
+// print_poster
+
+//! \brief The fixed benchmark corpus
+std::vector<Sample> corpus (void)
+{
+	static const int sizes[] = { 5, 7, 10 };
+	static const double loops[] = { 0, 0.1 };
+	static const char *posters[] = { "etc/whitemaze234.maze", "etc/graymaze128.maze", "etc/colormaze357.maze" };
+	std::vector<Sample> c;
+	for (int i = 0; i < 3; i++) {
+		Sample e = { posters[i], Maze::load(posters[i]) };
+		c.push_back(e);
+	}
+	for (int type = MAZE_WHITE; type <= MAZE_COLOR; type++)
+		for (int s = 0; s < 3; s++)
+			for (int l = 0; l < 2; l++) {
+				char name[64];
+				unsigned long long seed = 1000 + 10 * s + l;
+				snprintf(name, sizeof(name), "gen:%dx%d:seed=%llu:loops=%.2f", sizes[s], sizes[s], seed, loops[l]);
+				Sample e = { name, generate(type, sizes[s], sizes[s], seed, loops[l]) };
+				c.push_back(e);
+			}
+	return c;
+}
+// corpus
+
+//! \brief The traps added to the corpus to compare the solvers
+std::vector<Sample> traps (void)
+{
+	std::vector<Sample> c;
+	for (int type = MAZE_WHITE; type <= MAZE_COLOR; type++) {
+		Sample e = { "gen:7x7:seed=1050:trap", trap(type, 7, 7, 1050) };
+		c.push_back(e);
+	}
+	return c;
+}
+// traps
+
+} // namespace sim
@@ -0,0 +1,64 @@
+/*! \file generator.h
+	\brief Maze generator and poster printer
+
+	Generates random mazes from a seed. The same seed, size and
+	options always give the same maze, on any host.
+
+	Perfect mazes are spanning trees of the junction grid, generated
+	by a randomized depth first search which backtracks through parent
+	directions stored per junction instead of an explicit stack. It
+	needs a byte per junction and is linear in the number of junctions,
+	such that grids of many millions of junctions are generated in
+	seconds. Imperfect mazes add random lines to a perfect maze, which
+	creates loops.
+
+	The start is the north eastern junction, like on the posters in etc/,
+	heading west if possible.
+	The exit is a random junction on the border of the grid.
+
+	A trap is a perfect maze with the start on a square of lines in
+	the middle, which the right hand rule circles forever.
+
+	The benchmark corpus are the posters in etc/ and generated mazes of
+	each type from 5x5 to 10x10 junctions, perfect and with loops. It
+	must be loaded from the top directory. The right hand rule gets out
+	of all of them. A 7x7 trap of each type is kept apart, mazebatch
+	adds them to compare the solvers.
+
+	\author agent
+	\version 20261016
+
+	Changelog:
+		- 20261016 agent
+			- initial version
+			- benchmark corpus
+			- trap mazes
+			- traps out of the benchmark corpus
+*/
+#ifndef SIM_GENERATOR_H
+#define SIM_GENERATOR_H 1
+
+#include <string>
+#include <vector>
+#include "maze.h"
+#include "random.h"
+
+namespace sim {
+
+#define POSTER_SIZE    1000    //!< mm, edge of a 1 m^2 poster
+
+//! \brief A named maze
+struct Sample {
+	std::string name;    //!< maze file or generator parameters
+	Maze maze;           //!< the maze
+};
+
+Maze generate (int type, int cols, int rows, unsigned long long seed, double loops);
+Maze trap (int type, int cols, int rows, unsigned long long seed);
+void print_poster (const Maze &maze, const WorldMetrics &m, const std::string &path);
+std::vector<Sample> corpus (void);
+std::vector<Sample> traps (void);
+
+} // namespace sim
+
+#endif // SIM_GENERATOR_H
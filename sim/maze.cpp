@@ -0,0 +1,330 @@
+/*! \file maze.cpp
+	\brief Simulated maze posters
+
+	\author agent
+	\version 20261016
+
+	Changelog:
+		- 20261016 agent
+			- initial version
+			- packed grid
+*/
+#include <cmath>
+#include <stdexcept>
+#include "maze.h"
+
+namespace sim {
+
+/*
+	Light and HT color numbers per maze type and kind of surface,
+	ordered background, line, junction, exit, table. The light values
+	of lines, junctions and background are WHITE_LINE, WHITE_JUNC,
+	WHITE_BACK and so on from world.h.
+*/
+static const Shade shades[3][KIND_COUNT] = {
+	// MAZE_WHITE: white background, grey lines, black junctions and exit
+	{ {62, 17}, {50, 13}, {33, 0}, {33, 0}, {45, 14} },
+	// MAZE_GRAY: gray background, white lines, black junctions and exit
+	{ {52, 13}, {67, 17}, {40, 0}, {40, 0}, {45, 14} },
+	// MAZE_COLOR: white background, black lines, red junctions, blue exit
+	{ {62, 17}, {28, 0}, {47, 8}, {38, 2}, {45, 14} }
+};
+
+static const char *type_names[] = { "white", "gray", "color" };
+static const char *dir_names[] = { "east", "north", "west", "south" };
+
+Maze::Maze (void)
+	: mtype(MAZE_COLOR), ncols(0), nrows(0), grid(0),
+	  sx(0), sy(0), sdir(DIR_EAST), ex(0), ey(0), edir(DIR_EAST)
+{
+}
+
+Maze::Maze (int type, int cols, int rows)
+	: mtype(type), ncols(cols), nrows(rows), grid(0),
+	  sx(0), sy(0), sdir(DIR_EAST), ex(0), ey(0), edir(DIR_EAST)
+{
+	if (type < MAZE_WHITE || type > MAZE_COLOR)
+		throw std::invalid_argument("unknown maze type");
+	if (cols < 1 || rows < 1 || (long long)cols * rows > 0x40000000LL)
+		throw std::invalid_argument("invalid maze size");
+	cells.assign(grid_size(), 0);
+	grid = &cells[0];
+}
+// Maze
+
+//! \brief Copies a maze, a mapped grid is copied into memory
+Maze::Maze (const Maze &other)
+	: mtype(other.mtype), ncols(other.ncols), nrows(other.nrows),
+	  cells(other.grid, other.grid + other.grid_size()), grid(0),
+	  sx(other.sx), sy(other.sy), sdir(other.sdir),
+	  ex(other.ex), ey(other.ey), edir(other.edir)
+{
+	if (!cells.empty()) grid = &cells[0];
+}
+// Maze
+
+Maze::Maze (Maze &&other)
+	: mtype(other.mtype), ncols(other.ncols), nrows(other.nrows),
+	  cells(std::move(other.cells)), mapping(std::move(other.mapping)), grid(other.grid),
+	  sx(other.sx), sy(other.sy), sdir(other.sdir),
+	  ex(other.ex), ey(other.ey), edir(other.edir)
+{
+	other.grid = 0;
+	other.ncols = other.nrows = 0;
+}
+// Maze
+
+Maze &Maze::operator= (const Maze &other)
+{
+	if (this != &other) *this = Maze(other);
+	return *this;
+}
+
+Maze &Maze::operator= (Maze &&other)
+{
+	if (this == &other) return *this;
+	mtype = other.mtype; ncols = other.ncols; nrows = other.nrows;
+	cells = std::move(other.cells);
+	mapping = std::move(other.mapping);
+	grid = other.grid;
+	sx = other.sx; sy = other.sy; sdir = other.sdir;
+	ex = other.ex; ey = other.ey; edir = other.edir;
+	other.grid = 0;
+	other.ncols = other.nrows = 0;
+	return *this;
+}
+
+//! \brief Bytes of the packed grid, four junctions per byte
+size_t Maze::grid_size (void) const
+{
+	return ((size_t)ncols * nrows + 3) / 4;
+}
+// grid_size
+
+//! \brief Line bits of junction (x,y)
+int Maze::bits (int x, int y) const
+{
+	size_t k = (size_t)y * ncols + x;
+	return (grid[k >> 2] >> ((k & 3) << 1)) & 0x03;
+}
+// bits
+
+/*!
+	\brief Sets or clears line bits of junction (x,y)
+
+	A mapped grid is private to this maze, changes are not
+	written back to the file.
+*/
+void Maze::set_bits (int x, int y, int mask, bool on)
+{
+	size_t k = (size_t)y * ncols + x;
+	unsigned char m = (unsigned char)(mask << ((k & 3) << 1));
+	if (on) grid[k >> 2] |= m;
+	else grid[k >> 2] &= ~m;
+}
+// set_bits
+
+//! \brief x component of a direction
+int Maze::dx (int dir)
+{
+	return (dir == DIR_EAST) ? 1 : (dir == DIR_WEST) ? -1 : 0;
+}
+// dx
+
+//! \brief y component of a direction
+int Maze::dy (int dir)
+{
+	return (dir == DIR_NORTH) ? 1 : (dir == DIR_SOUTH) ? -1 : 0;
+}
+// dy
+
+//! \brief Maze type of a name like "gray", 0 if unknown
+int Maze::type_of (const std::string &name)
+{
+	for (int i = 0; i < 3; i++) if (name == type_names[i]) return MAZE_WHITE + i;
+	return 0;
+}
+// type_of
+
+//! \brief Name of a maze type
+const char *Maze::type_name (int type)
+{
+	return (type >= MAZE_WHITE && type <= MAZE_COLOR) ? type_names[type - MAZE_WHITE] : "unknown";
+}
+// type_name
+
+//! \brief Direction of a name like "north", -1 if unknown
+int Maze::dir_of (const std::string &name)
+{
+	for (int i = 0; i < 4; i++) if (name == dir_names[i]) return i;
+	return -1;
+}
+// dir_of
+
+//! \brief Name of a direction
+const char *Maze::dir_name (int dir)
+{
+	return dir_names[dir & 0x03];
+}
+// dir_name
+
+//! \brief True if junction (x,y) is part of the grid
+bool Maze::contains (int x, int y) const
+{
+	return (x >= 0) && (y >= 0) && (x < ncols) && (y < nrows);
+}
+// contains
+
+/*!
+	\brief Links junction (x,y) with its neighbour in direction dir
+
+	Lines are stored once, as east or north line of the
+	western or southern junction.
+*/
+void Maze::link (int x, int y, int dir)
+{
+	int nx = x + dx(dir), ny = y + dy(dir);
+	if (!contains(x, y) || !contains(nx, ny))
+		throw std::out_of_range("line leaves the maze");
+	if (dir == DIR_EAST) set_bits(x, y, LINK_EAST, true);
+	else if (dir == DIR_NORTH) set_bits(x, y, LINK_NORTH, true);
+	else if (dir == DIR_WEST) set_bits(nx, ny, LINK_EAST, true);
+	else set_bits(nx, ny, LINK_NORTH, true);
+}
+// link
+
+//! \brief Removes the line of junction (x,y) in direction dir
+void Maze::unlink (int x, int y, int dir)
+{
+	int nx = x + dx(dir), ny = y + dy(dir);
+	if (!contains(x, y) || !contains(nx, ny)) return;
+	if (dir == DIR_EAST) set_bits(x, y, LINK_EAST, false);
+	else if (dir == DIR_NORTH) set_bits(x, y, LINK_NORTH, false);
+	else if (dir == DIR_WEST) set_bits(nx, ny, LINK_EAST, false);
+	else set_bits(nx, ny, LINK_NORTH, false);
+}
+// unlink
+
+//! \brief True if a line leaves junction (x,y) in direction dir
+bool Maze::linked (int x, int y, int dir) const
+{
+	int nx = x + dx(dir), ny = y + dy(dir);
+	if (!contains(x, y) || !contains(nx, ny)) return false;
+	if (dir == DIR_EAST) return bits(x, y) & LINK_EAST;
+	if (dir == DIR_NORTH) return bits(x, y) & LINK_NORTH;
+	if (dir == DIR_WEST) return bits(nx, ny) & LINK_EAST;
+	return bits(nx, ny) & LINK_NORTH;
+}
+// linked
+
+//! \brief Places the robot on junction (x,y) heading dir
+void Maze::set_start (int x, int y, int dir)
+{
+	if (!contains(x, y)) throw std::out_of_range("start outside the maze");
+	sx = x; sy = y; sdir = dir & 0x03;
+}
+// set_start
+
+//! \brief Marks junction (x,y) as exit, the strip leads off in direction dir
+void Maze::set_exit (int x, int y, int dir)
+{
+	if (!contains(x, y)) throw std::out_of_range("exit outside the maze");
+	ex = x; ey = y; edir = dir & 0x03;
+}
+// set_exit
+
+//! \brief Distance between two junction centers in mm
+double Maze::pitch (const WorldMetrics &m) const
+{
+	return m.len_junc + m.len_line;
+}
+// pitch
+
+//! \brief Width of the poster in mm
+double Maze::width (const WorldMetrics &m) const
+{
+	return (ncols + 1) * pitch(m);
+}
+// width
+
+//! \brief Height of the poster in mm
+double Maze::height (const WorldMetrics &m) const
+{
+	return (nrows + 1) * pitch(m);
+}
+// height
+
+/*!
+	\brief Kind of surface at position (x,y) in mm
+
+	Only the nearest junction and the exit strip need to be
+	checked, which makes the lookup O(1) for any maze size.
+*/
+int Maze::kind (const WorldMetrics &m, double x, double y) const
+{
+	double p = pitch(m);
+	// the exit strip may lead off the poster
+	double ax = x - (ex + 1) * p, ay = y - (ey + 1) * p;
+	double along = ax * dx(edir) + ay * dy(edir);
+	double across = ax * dy(edir) - ay * dx(edir);
+	if ((along > m.len_junc / 2.0) && (std::fabs(across) <= m.wid_junc / 2.0)) {
+		double end = (edir == DIR_EAST || edir == DIR_WEST) ? width(m) : height(m);
+		double pos = (edir == DIR_EAST) ? x : (edir == DIR_NORTH) ? y :
+			(edir == DIR_WEST) ? end - x : end - y;
+		if (pos <= end) return KIND_EXIT;
+	}
+	if ((x < 0) || (y < 0) || (x > width(m)) || (y > height(m))) return KIND_TABLE;
+	// nearest junction
+	int i = (int)std::floor(x / p + 0.5) - 1;
+	int j = (int)std::floor(y / p + 0.5) - 1;
+	if (!contains(i, j)) return KIND_BACKGROUND;
+	double jx = x - (i + 1) * p, jy = y - (j + 1) * p;
+	if ((std::fabs(jx) <= m.len_junc / 2.0) && (std::fabs(jy) <= m.wid_junc / 2.0))
+		return KIND_JUNC;
+	if ((std::fabs(jy) <= m.wid_line / 2.0) && linked(i, j, (jx > 0) ? DIR_EAST : DIR_WEST))
+		return KIND_LINE;
+	if ((std::fabs(jx) <= m.wid_line / 2.0) && linked(i, j, (jy > 0) ? DIR_NORTH : DIR_SOUTH))
+		return KIND_LINE;
+	return KIND_BACKGROUND;
+}
+// kind
+
+//! \brief Sensor readings on a kind of surface of this maze type
+const Shade &Maze::shade (int kind) const
+{
+	return shades[mtype - MAZE_WHITE][kind];
+}
+// shade
+
+/*!
+	\brief A small built-in maze
+
+	A 4x4 maze with one loop and two dead ends, start in the
+	lower left corner heading north, exit on the right.
+*/
+Maze Maze::demo (int type)
+{
+	Maze maze(type, 4, 4);
+	maze.link(0, 0, DIR_NORTH);
+	maze.link(0, 1, DIR_NORTH);
+	maze.link(0, 2, DIR_NORTH);
+	maze.link(0, 3, DIR_EAST);
+	maze.link(1, 3, DIR_SOUTH);
+	maze.link(1, 2, DIR_SOUTH);
+	maze.link(1, 1, DIR_EAST);
+	maze.link(2, 1, DIR_NORTH);
+	maze.link(2, 2, DIR_NORTH);
+	maze.link(2, 3, DIR_EAST);
+	maze.link(2, 1, DIR_SOUTH);
+	maze.link(2, 0, DIR_WEST);
+	maze.link(2, 0, DIR_EAST);
+	maze.link(3, 0, DIR_NORTH);
+	maze.link(3, 1, DIR_NORTH);
+	maze.link(1, 2, DIR_EAST);
+	maze.set_start(0, 0, DIR_NORTH);
+	maze.set_exit(3, 2, DIR_EAST);
+	return maze;
+}
+// demo
+
+} // namespace sim
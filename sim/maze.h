@@ -0,0 +1,150 @@
+/*! \file maze.h
+	\brief Simulated maze posters
+
+	A maze is a rectangular grid of junctions. Adjacent junctions
+	can be linked by a line. One junction is the start, where the
+	robot is placed heading along one of its lines. One junction
+	is the exit, which is marked by a strip in exit color leading
+	off the poster.
+
+	The topology is independent of the maze type. The geometry in mm
+	is derived from the metrics in world.h of the maze type.
+
+	The lines are stored packed, two bits per junction. Mazes are stored
+	in two file formats, see mazeio.cpp. The binary format holds the
+	packed grid as is, such that loading it maps the file instead of
+	parsing it. Mazes of a million junctions load in no time.
+	Junction (i,j) is centered at ((i+1)*pitch, (j+1)*pitch) with
+	pitch = LEN_JUNC + LEN_LINE, which leaves a border of one pitch
+	around the grid, like on the printed posters.
+
+	\author agent
+	\version 20261016
+
+	Changelog:
+		- 20261016 agent
+			- initial version
+			- packed grid, maze files
+*/
+#ifndef SIM_MAZE_H
+#define SIM_MAZE_H 1
+
+#include <memory>
+#include <string>
+#include <vector>
+
+// MAZE TYPES
+// same as in world.h
+#define MAZE_WHITE    0x01    //!< old-style maze with white background
+#define MAZE_GRAY     0x02    //!< new-style maze with gray background
+#define MAZE_COLOR    0x03    //!< brand-new color mazes
+
+namespace sim {
+
+// DIRECTIONS
+// counter clockwise, starting east
+#define DIR_EAST     0x00    //!< towards +x
+#define DIR_NORTH    0x01    //!< towards +y
+#define DIR_WEST     0x02    //!< towards -x
+#define DIR_SOUTH    0x03    //!< towards -y
+
+// LINES
+// bits of a junction in the packed grid
+#define LINK_EAST     0x01    //!< line to the east
+#define LINK_NORTH    0x02    //!< line to the north
+
+// KINDS OF SURFACE
+#define KIND_BACKGROUND    0x00    //!< poster background
+#define KIND_LINE          0x01    //!< a line between two junctions
+#define KIND_JUNC          0x02    //!< a junction
+#define KIND_EXIT          0x03    //!< the exit strip
+#define KIND_TABLE         0x04    //!< off the poster
+#define KIND_COUNT         0x05    //!< number of kinds
+
+//! \brief Metrics of a maze type, see world.h
+struct WorldMetrics {
+	int len_junc;    //!< LEN_JUNC
+	int wid_junc;    //!< WID_JUNC
+	int len_line;    //!< LEN_LINE
+	int wid_line;    //!< WID_LINE
+};
+
+//! \brief What the sensors read on a kind of surface
+struct Shade {
+	int light;    //!< reflected light in percent
+	int color;    //!< HT color number
+};
+
+struct Mapping;    // mazeio.cpp
+
+/*!
+	\brief A maze poster
+*/
+class Maze
+{
+public:
+	Maze (void);
+	Maze (int type, int cols, int rows);
+	Maze (const Maze &other);
+	Maze (Maze &&other);
+	Maze &operator= (const Maze &other);
+	Maze &operator= (Maze &&other);
+
+	int type (void) const { return mtype; }    //!< MAZE_WHITE, MAZE_GRAY or MAZE_COLOR
+	int cols (void) const { return ncols; }    //!< junctions in x direction
+	int rows (void) const { return nrows; }    //!< junctions in y direction
+
+	// TOPOLOGY
+	bool contains (int x, int y) const;
+	void link (int x, int y, int dir);
+	void unlink (int x, int y, int dir);
+	bool linked (int x, int y, int dir) const;
+	void set_start (int x, int y, int dir);
+	void set_exit (int x, int y, int dir);
+	int start_x (void) const { return sx; }
+	int start_y (void) const { return sy; }
+	int start_dir (void) const { return sdir; }
+	int exit_x (void) const { return ex; }
+	int exit_y (void) const { return ey; }
+	int exit_dir (void) const { return edir; }
+
+	// GEOMETRY
+	double pitch (const WorldMetrics &m) const;
+	double width (const WorldMetrics &m) const;
+	double height (const WorldMetrics &m) const;
+	int kind (const WorldMetrics &m, double x, double y) const;
+	const Shade &shade (int kind) const;
+
+	// FILES
+	static Maze load (const std::string &path);
+	void save (const std::string &path) const;
+	bool mapped (void) const { return (bool)mapping; }    //!< grid is a mapped file
+
+	static Maze demo (int type);
+	static int dx (int dir);
+	static int dy (int dir);
+	static int type_of (const std::string &name);
+	static const char *type_name (int type);
+	static int dir_of (const std::string &name);
+	static const char *dir_name (int dir);
+
+private:
+	int bits (int x, int y) const;
+	void set_bits (int x, int y, int mask, bool on);
+	size_t grid_size (void) const;
+	static Maze parse (const std::string &path, const char *text, size_t len);
+	static Maze map (const std::string &path, int fd, size_t len);
+
+	int mtype;                         //!< maze type
+	int ncols;                         //!< junctions in x direction
+	int nrows;                         //!< junctions in y direction
+	std::vector<unsigned char> cells;  //!< owned grid, empty if mapped
+	std::shared_ptr<Mapping> mapping;  //!< mapped maze file, shared by copies
+	unsigned char *grid;               //!< per junction two bits: line east, line north
+	int sx, sy, sdir;                  //!< start junction and heading
+	int ex, ey, edir;                  //!< exit junction and direction of the strip
+};
+
+} // namespace sim
+
+#endif // SIM_MAZE_H
@@ -0,0 +1,268 @@
+/*! \file mazebatch.cpp
+	\brief Parameter sweeps over many mazes on all cores
+
+	Usage: mazebatch [-j threads] [-n seeds] [-l limit] [-p param=values] ... [maze ...]
+
+	Runs src/maze.nxc for every combination of the swept parameters on
+	the benchmark corpus and the traps, see generator.h, or the given
+	maze files, each with seeds 1 to n. Each run explores the maze and
+	then replays it.
+	The runs are spread over all cores, see batch.h.
+
+	Parameters are the tunable variables of maze.nxc and world.h:
+	speed, sweep, center, tjunc, tline, tndef, replay, solver, cruise,
+	tedge, kp, ki, kd, period, calib, roll, ramp and glance. Values are
+	a comma separated list, a range from:to:step or both, e.g.
+
+		mazebatch -p speed=40:70:10 -p sweep=90,105,120
+		mazebatch -p replay=1,2
+		mazebatch -p solver=1,2,3
+		mazebatch -p kp=150:350:50 -p kd=0,32,64
+		mazebatch -p calib=0 -p tjunc=35:45:5
+
+	calibrate sets tjunc, tline, tndef and tedge from the light it
+	measures at the start, sweeps of them need calib=0.
+
+	Output is tab separated. A line per run, in the order of the runs,
+	is printed as soon as all runs before it are done. Then a line per
+	parameter set, best first: most runs exited, then the lowest mean
+	time to exit. Lines start with their record type, run or set, and
+	each table is preceded by a header line starting with #. A kept
+	parameter, i.e. the compiled value, is printed as -. The output
+	is the same for any number of threads.
+
+	\author agent
+	\version 20261016
+
+	Changelog:
+		- 20261016 agent
+			- initial version
+			- time of the replay
+			- line following parameters
+			- sample period
+			- calibration parameter
+			- roll parameter
+			- ramp parameter
+			- glance parameter
+			- mean time of the recoveries
+			- traps of the generator besides the corpus
+*/
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "batch.h"
+#include "generator.h"
+#include "runtime.h"
+
+using namespace sim;
+
+//! \brief Prints usage and exits
+static void usage (void)
+{
+	fprintf(stderr, "usage: mazebatch [-j threads] [-n seeds] [-l limit_ms] [-p param=values] ... [maze ...]\n");
+	exit(2);
+}
+// usage
+
+//! \brief Parses param=values into the values of a parameter
+static int sweep (const std::string &arg, std::vector<int> &values)
+{
+	size_t eq = arg.find('=');
+	if (eq == std::string::npos) usage();
+	int param = Params::find(arg.substr(0, eq));
+	if (param < 0) throw std::invalid_argument("unknown parameter " + arg.substr(0, eq));
+	std::istringstream in(arg.substr(eq + 1));
+	std::string item;
+	while (std::getline(in, item, ',')) {
+		int from, to, step;
+		char c1, c2;
+		std::istringstream is(item);
+		if ((is >> from >> c1 >> to >> c2 >> step) && (c1 == ':') && (c2 == ':') && (step > 0)) {
+			for (int v = from; v <= to; v += step) values.push_back(v);
+		} else {
+			char *end;
+			long v = strtol(item.c_str(), &end, 10);
+			if (item.empty() || *end) throw std::invalid_argument("invalid value " + item);
+			values.push_back((int)v);
+		}
+	}
+	if (values.empty()) throw std::invalid_argument("no values for " + arg);
+	return param;
+}
+// sweep
+
+//! \brief Prints the values of a parameter set
+static void print_params (const Params &p)
+{
+	for (int i = 0; i < PARAM_COUNT; i++) {
+		if (p.value[i] == PARAM_KEEP) printf("\t-");
+		else printf("\t%d", p.value[i]);
+	}
+}
+// print_params
+
+//! \brief Aggregated results of a parameter set
+struct Score {
+	size_t set;          //!< index of the set
+	int runs;            //!< number of runs
+	int exited;          //!< runs that reached the exit
+	int lost;            //!< runs that left the poster
+	long long t_exit;    //!< sum of the times to exit of exited runs
+	double distance;     //!< sum of the distances
+	long recoveries;     //!< sum of the NDEF recoveries
+	int found;           //!< NDEF recoveries which found a surface
+	long long t_recovery;  //!< sum of the times of these recoveries
+	int replayed;        //!< runs whose replay reached the exit
+	long long t_replay;  //!< sum of the times of the replays that reached the exit
+	double mean (void) const { return exited ? (double)t_exit / exited : 0; }
+	double mean_replay (void) const { return replayed ? (double)t_replay / replayed : 0; }
+	double mean_recovery (void) const { return found ? (double)t_recovery / found : 0; }
+};
+
+//! \brief Better scores first
+static bool better (const Score &a, const Score &b)
+{
+	if (a.exited != b.exited) return a.exited > b.exited;
+	if (a.mean() != b.mean()) return a.mean() < b.mean();
+	return a.set < b.set;
+}
+// better
+
+int main (int argc, char **argv)
+{
+	const int ndef = find_state(model_color, "ndef");
+	int threads = 0;
+	unsigned long long seeds = 1;
+	long limit = Config().limit;
+	std::vector<int> swept;
+	std::vector<std::vector<int> > values;
+	std::vector<Sample> mazes;
+	try {
+		for (int i = 1; i < argc; i++) {
+			if ((strcmp(argv[i], "-j") == 0) && (i + 1 < argc)) threads = atoi(argv[++i]);
+			else if ((strcmp(argv[i], "-n") == 0) && (i + 1 < argc)) seeds = strtoull(argv[++i], 0, 10);
+			else if ((strcmp(argv[i], "-l") == 0) && (i + 1 < argc)) limit = atol(argv[++i]);
+			else if ((strcmp(argv[i], "-p") == 0) && (i + 1 < argc)) {
+				values.push_back(std::vector<int>());
+				swept.push_back(sweep(argv[++i], values.back()));
+			} else if (argv[i][0] != '-') {
+				Sample e = { argv[i], Maze::load(argv[i]) };
+				mazes.push_back(e);
+			} else usage();
+		}
+		if (mazes.empty()) {
+			mazes = corpus();
+			std::vector<Sample> t = traps();
+			mazes.insert(mazes.end(), t.begin(), t.end());
+		}
+	} catch (const std::exception &e) {
+		fprintf(stderr, "mazebatch: %s\n", e.what());
+		return 2;
+	}
+	if (seeds < 1) usage();
+
+	// cartesian product of the swept values, the last parameter varies fastest
+	std::vector<Params> sets(1);
+	for (size_t k = 0; k < swept.size(); k++) {
+		std::vector<Params> next;
+		for (size_t s = 0; s < sets.size(); s++)
+			for (size_t v = 0; v < values[k].size(); v++) {
+				Params p = sets[s];
+				p.value[swept[k]] = values[k][v];
+				next.push_back(p);
+			}
+		sets.swap(next);
+	}
+
+	size_t jobs = sets.size() * mazes.size() * seeds;
+	std::vector<Result> results(jobs);
+	std::vector<char> done(jobs, 0);
+	size_t printed = 0;
+	std::mutex lock;
+	printf("# run\tset\tmaze\ttype\tseed");
+	for (int i = 0; i < PARAM_COUNT; i++) printf("\t%s", Params::name(i));
+	printf("\texited\tlost\tt_exit\tdistance\trecoveries\tt_replay\n");
+	fflush(stdout);
+
+	Pool pool(threads);
+	std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+	try {
+		pool.run(jobs, [&](size_t job) {
+			size_t set = job / (mazes.size() * seeds);
+			const Maze &maze = mazes[(job / seeds) % mazes.size()].maze;
+			Config cfg;
+			cfg.seed = job % seeds + 1;
+			cfg.limit = limit;
+			cfg.runs = 2;
+			cfg.params = sets[set];
+			Runtime rt(find_model(maze.type()), maze, cfg);
+			Result r = rt.run();
+			// print all runs which are done, in order
+			std::lock_guard<std::mutex> g(lock);
+			results[job] = r;
+			done[job] = 1;
+			for (; (printed < jobs) && done[printed]; printed++) {
+				size_t s = printed / (mazes.size() * seeds);
+				const Sample &m = mazes[(printed / seeds) % mazes.size()];
+				const Result &p = results[printed];
+				printf("run\t%zu\t%s\t%s\t%llu", s, m.name.c_str(), Maze::type_name(m.maze.type()),
+					printed % seeds + 1);
+				print_params(sets[s]);
+				printf("\t%d\t%d\t%ld\t%.0f\t%d\t%ld\n", p.exited, p.lost, p.t_exit, p.distance, p.entered[ndef],
+					(p.runs > 1) ? p.t_run[1] : 0);
+			}
+			fflush(stdout);
+		});
+	} catch (const std::exception &e) {
+		fprintf(stderr, "mazebatch: %s\n", e.what());
+		return 2;
+	}
+	double secs = std::chrono::duration_cast<std::chrono::milliseconds>(
+		std::chrono::steady_clock::now() - t0).count() / 1000.0;
+
+	std::vector<Score> scores(sets.size());
+	for (size_t s = 0; s < sets.size(); s++) {
+		Score &sc = scores[s];
+		sc.set = s;
+		sc.runs = 0; sc.exited = 0; sc.lost = 0;
+		sc.t_exit = 0; sc.distance = 0; sc.recoveries = 0; sc.found = 0; sc.t_recovery = 0;
+		sc.replayed = 0; sc.t_replay = 0;
+		for (size_t j = s * mazes.size() * seeds; j < (s + 1) * mazes.size() * seeds; j++) {
+			const Result &r = results[j];
+			sc.runs++;
+			sc.exited += r.exited;
+			sc.lost += r.lost;
+			if (r.exited) sc.t_exit += r.t_exit;
+			sc.distance += r.distance;
+			sc.recoveries += r.entered[ndef];
+			sc.found += r.visits[ndef];
+			sc.t_recovery += r.t_visits[ndef];
+			if (r.runs > 1) {
+				sc.replayed++;
+				sc.t_replay += r.t_run[1];
+			}
+		}
+	}
+	std::sort(scores.begin(), scores.end(), better);
+	printf("# set\tindex\trank");
+	for (int i = 0; i < PARAM_COUNT; i++) printf("\t%s", Params::name(i));
+	printf("\truns\texited\tlost\tmean_t_exit\tmean_distance\trecoveries\tmean_t_recovery\treplayed\tmean_t_replay\n");
+	for (size_t k = 0; k < scores.size(); k++) {
+		const Score &sc = scores[k];
+		printf("set\t%zu\t%zu", sc.set, k + 1);
+		print_params(sets[sc.set]);
+		printf("\t%d\t%d\t%d\t%.0f\t%.0f\t%ld\t%.0f\t%d\t%.0f\n", sc.runs, sc.exited, sc.lost, sc.mean(),
+			sc.distance / sc.runs, sc.recoveries, sc.mean_recovery(), sc.replayed, sc.mean_replay());
+	}
+	fprintf(stderr, "mazebatch: %zu runs in %.1f s on %d threads\n", jobs, secs, pool.threads());
+	return 0;
+}
+// main
@@ -0,0 +1,199 @@
+/*! \file mazebench.cpp
+	\brief Benchmarks the maze solver in the simulator
+
+	Usage: mazebench [-n seeds] [maze ...]
+	       mazebench -g
+
+	Runs src/maze.nxc over a fixed corpus of mazes, or the given maze
+	files, each with seeds 1 to n, and prints one tab separated line per
+	run. Each run explores the maze and then replays the route it
+	mapped. The first line names the columns:
+
+		maze        maze file or generator parameters
+		type        maze type
+		cols, rows  size of the maze
+		seed        seed of the run
+		exited      1 if the exit was reached
+		lost        1 if the robot left the poster
+		t_exit      simulated ms until the exit was reached
+		t_end       simulated ms until the run ended
+		t_replay    simulated ms of the replay of the mapped route from
+		            the start to the exit, 0 if it did not get there
+		distance    mm driven
+		turns       turns on the spot
+		recoveries  transitions into STATE_NDEF
+		t_recovery  mean simulated ms from a transition into STATE_NDEF
+		            to the next state, recoveries still searching when
+		            the run ended left out
+		stops       stops of the drive caused by a change of the surface
+		stop_us     mean simulated us from the change of the surface
+		            under the sensor to the stop, see runtime.h
+		stop_max    simulated us of the slowest of these stops
+		ms_<state>  simulated ms spent in each state of maze.nxc
+		wall_us     host time of the run in us
+
+	All columns but wall_us only depend on the sources, such that the
+	output of two commits can be compared with diff. The last line
+	sums all runs, its exited and lost columns count runs. Its
+	t_replay sums the replays that got to the exit, its t_recovery
+	and stop_us are the means over the recoveries and the stops of
+	all runs.
+
+	The corpus is described in generator.h.
+
+	With -g it instead looks up the same random lines of the packed
+	grid of src/grid.h and of a naive grid with a bool per line and
+	prints the mean host ns of a lookup in both.
+
+	\author agent
+	\version 20261016
+
+	Changelog:
+		- 20261016 agent
+			- initial version
+			- corpus moved to generator.cpp
+			- replay of the mapped route
+			- latency of stops
+			- mean time of the recoveries
+			- speed of the packed grid, from testsim
+*/
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <string>
+#include <vector>
+#include "generator.h"
+#include "packed.h"
+#include "runtime.h"
+
+using namespace sim;
+
+#define BENCH_LIMIT    1800000    //!< ms of simulated time per run
+#define BENCH_LOOKUPS  4000000    //!< lookups of each grid
+
+/*!
+	\brief Times lookups of the packed grid and of a naive one
+
+	Both grids get the same random lines, then the same random
+	lines are looked up in both. Prints the mean ns of a lookup.
+
+	\return	0 if both grids agree on all lookups
+*/
+static int bench_grid (void)
+{
+	const int cells = GRID_COLS * GRID_ROWS;
+	PackedGrid packed;
+	std::vector<char> naive(cells * 4, 0);
+	Random rnd(9);
+	for (int k = 0; k < cells; k++) {
+		int x = rnd.below(GRID_COLS), y = rnd.below(GRID_ROWS), d = rnd.below(4);
+		if (!packed.grid_link(x, y, d)) continue;
+		int nx = x + ((d == GRID_DIR_EAST) ? 1 : (d == GRID_DIR_WEST) ? -1 : 0);
+		int ny = y + ((d == GRID_DIR_NORTH) ? 1 : (d == GRID_DIR_SOUTH) ? -1 : 0);
+		naive[(y * GRID_COLS + x) * 4 + d] = 1;
+		naive[(ny * GRID_COLS + nx) * 4 + (d + 2) % 4] = 1;
+	}
+	std::vector<int> where(4096);
+	for (size_t i = 0; i < where.size(); i++) where[i] = rnd.below(cells * 4);
+	long found[2] = { 0, 0 };
+	long long ns[2];
+	for (int g = 0; g < 2; g++) {
+		std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+		for (int k = 0; k < BENCH_LOOKUPS; k++) {
+			int w = where[k & 4095], i = w >> 2, d = w & 3;
+			if (g == 0) found[g] += packed.grid_line(i % GRID_COLS, i / GRID_COLS, d);
+			else found[g] += naive[w];
+		}
+		ns[g] = std::chrono::duration_cast<std::chrono::nanoseconds>(
+			std::chrono::steady_clock::now() - t0).count();
+	}
+	printf("grid\tpacked_ns\tnaive_ns\n");
+	printf("lookup\t%.2f\t%.2f\n", (double)ns[0] / BENCH_LOOKUPS, (double)ns[1] / BENCH_LOOKUPS);
+	return (found[0] == found[1]) ? 0 : 1;
+}
+// bench_grid
+
+int main (int argc, char **argv)
+{
+	unsigned long long seeds = 2;
+	std::vector<Sample> mazes;
+	try {
+		for (int i = 1; i < argc; i++) {
+			if ((strcmp(argv[i], "-n") == 0) && (i + 1 < argc)) seeds = strtoull(argv[++i], 0, 10);
+			else if (strcmp(argv[i], "-g") == 0) return bench_grid();
+			else if (argv[i][0] != '-') {
+				Sample e = { argv[i], Maze::load(argv[i]) };
+				mazes.push_back(e);
+			} else {
+				fprintf(stderr, "usage: mazebench [-n seeds] [maze ...] | mazebench -g\n");
+				return 2;
+			}
+		}
+		if (mazes.empty()) mazes = corpus();
+	} catch (const std::exception &e) {
+		fprintf(stderr, "mazebench: %s\n", e.what());
+		return 2;
+	}
+	// all compilations share the states of maze.nxc
+	const State *states = model_color.states;
+	const int ndef = find_state(model_color, "ndef");
+	printf("maze\ttype\tcols\trows\tseed\texited\tlost\tt_exit\tt_end\tt_replay\tdistance\tturns\trecoveries\tt_recovery");
+	printf("\tstops\tstop_us\tstop_max");
+	for (const State *s = states; s->name; s++) printf("\tms_%s", s->name);
+	printf("\twall_us\n");
+	Result total;
+	long long wall = 0;
+	int exited = 0, lost = 0;
+	long t_replay = 0;
+	for (size_t i = 0; i < mazes.size(); i++) {
+		const Maze &maze = mazes[i].maze;
+		const Model &model = find_model(maze.type());
+		for (unsigned long long seed = 1; seed <= seeds; seed++) {
+			Config cfg;
+			cfg.seed = seed;
+			cfg.limit = BENCH_LIMIT;
+			cfg.runs = 2;
+			std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+			Runtime rt(model, maze, cfg);
+			Result r = rt.run();
+			long long us = std::chrono::duration_cast<std::chrono::microseconds>(
+				std::chrono::steady_clock::now() - t0).count();
+			long replay = (r.runs > 1) ? r.t_run[1] : 0;
+			printf("%s\t%s\t%d\t%d\t%llu\t%d\t%d\t%ld\t%ld\t%ld\t%.0f\t%d\t%d",
+				mazes[i].name.c_str(), model.name, maze.cols(), maze.rows(), seed,
+				r.exited, r.lost, r.t_exit, r.t_end, replay, r.distance, r.turns, r.entered[ndef]);
+			printf("\t%ld", r.visits[ndef] ? r.t_visits[ndef] / r.visits[ndef] : 0);
+			printf("\t%d\t%lld\t%ld", r.stops, r.stops ? r.t_stops / r.stops : 0, r.t_stop_max);
+			for (const State *s = states; s->name; s++) printf("\t%ld", r.t_state[s->id]);
+			printf("\t%lld\n", us);
+			fflush(stdout);
+			exited += r.exited;
+			lost += r.lost;
+			total.t_exit += r.t_exit;
+			total.t_end += r.t_end;
+			t_replay += replay;
+			total.distance += r.distance;
+			total.turns += r.turns;
+			total.stops += r.stops;
+			total.t_stops += r.t_stops;
+			if (r.t_stop_max > total.t_stop_max) total.t_stop_max = r.t_stop_max;
+			for (int k = 0; k < STATE_SLOTS; k++) {
+				total.t_state[k] += r.t_state[k];
+				total.entered[k] += r.entered[k];
+				total.visits[k] += r.visits[k];
+				total.t_visits[k] += r.t_visits[k];
+			}
+			wall += us;
+		}
+	}
+	printf("total\t-\t-\t-\t-\t%d\t%d\t%ld\t%ld\t%ld\t%.0f\t%d\t%d",
+		exited, lost, total.t_exit, total.t_end, t_replay, total.distance, total.turns, total.entered[ndef]);
+	printf("\t%ld", total.visits[ndef] ? total.t_visits[ndef] / total.visits[ndef] : 0);
+	printf("\t%d\t%lld\t%ld", total.stops, total.stops ? total.t_stops / total.stops : 0, total.t_stop_max);
+	for (const State *s = states; s->name; s++) printf("\t%ld", total.t_state[s->id]);
+	printf("\t%lld\n", wall);
+	return (exited == (int)(mazes.size() * seeds)) ? 0 : 1;
+}
+// main
@@ -0,0 +1,37 @@
+/*! \file mazeconv.cpp
+	\brief Converts maze files
+
+	Usage: mazeconv <in> <out>
+
+	Converts between the text (.maze) and binary (.mzb) maze
+	formats, see mazeio.cpp. The output format is chosen by the
+	extension of the output file.
+
+	\author agent
+	\version 20261016
+
+	Changelog:
+		- 20261016 agent
+			- initial version
+*/
+#include <cstdio>
+#include <exception>
+#include "maze.h"
+
+using namespace sim;
+
+int main (int argc, char **argv)
+{
+	if (argc != 3) {
+		fprintf(stderr, "usage: mazeconv <in> <out>\n");
+		return 2;
+	}
+	try {
+		Maze::load(argv[1]).save(argv[2]);
+	} catch (const std::exception &e) {
+		fprintf(stderr, "mazeconv: %s\n", e.what());
+		return 1;
+	}
+	return 0;
+}
+// main
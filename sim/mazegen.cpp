@@ -0,0 +1,76 @@
+/*! \file mazegen.cpp
+	\brief Generates mazes and posters
+
+	Usage: mazegen [-t type] [-s seed] [-l loops] [-o maze] [-p poster] [cols rows]
+
+	Generates a random maze of the given type and size, saves it as
+	text or binary maze file, see mazeio.cpp, and prints it as PDF
+	poster. Without a size the maze fills a 1 m^2 poster. The same
+	seed always gives the same maze. loops is the probability of
+	adding a line that closes a loop, 0 gives a perfect maze.
+
+	\author agent
+	\version 20261016
+
+	Changelog:
+		- 20261016 agent
+			- initial version
+*/
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include "generator.h"
+#include "program.h"
+
+using namespace sim;
+
+//! \brief Prints usage and exits
+static void usage (void)
+{
+	fprintf(stderr, "usage: mazegen [-t white|gray|color] [-s seed] [-l loops] [-o maze] [-p poster.pdf] [cols rows]\n");
+	exit(2);
+}
+// usage
+
+int main (int argc, char **argv)
+{
+	int type = MAZE_COLOR;
+	unsigned long long seed = 1;
+	double loops = 0;
+	const char *out = 0, *poster = 0;
+	int size[2] = { 0, 0 }, n = 0;
+	for (int i = 1; i < argc; i++) {
+		if ((strcmp(argv[i], "-t") == 0) && (i + 1 < argc)) {
+			type = Maze::type_of(argv[++i]);
+			if (!type) usage();
+		}
+		else if ((strcmp(argv[i], "-s") == 0) && (i + 1 < argc)) seed = strtoull(argv[++i], 0, 10);
+		else if ((strcmp(argv[i], "-l") == 0) && (i + 1 < argc)) loops = atof(argv[++i]);
+		else if ((strcmp(argv[i], "-o") == 0) && (i + 1 < argc)) out = argv[++i];
+		else if ((strcmp(argv[i], "-p") == 0) && (i + 1 < argc)) poster = argv[++i];
+		else if ((argv[i][0] != '-') && (n < 2)) size[n++] = atoi(argv[i]);
+		else usage();
+	}
+	if ((n == 1) || (loops < 0) || (loops > 1)) usage();
+	if (!out && !poster) usage();
+	const WorldMetrics &m = find_model(type).world;
+	if (n == 0) {
+		// as many junctions as fit on the poster, leaving a border of one pitch
+		size[0] = size[1] = (int)(POSTER_SIZE / (m.len_junc + m.len_line)) - 1;
+	}
+	try {
+		Maze maze = generate(type, size[0], size[1], seed, loops);
+		if (out) maze.save(out);
+		if (poster) {
+			if ((maze.width(m) > POSTER_SIZE) || (maze.height(m) > POSTER_SIZE))
+				fprintf(stderr, "mazegen: warning: maze does not fit a 1 m^2 poster\n");
+			print_poster(maze, m, poster);
+		}
+	} catch (const std::exception &e) {
+		fprintf(stderr, "mazegen: %s\n", e.what());
+		return 1;
+	}
+	return 0;
+}
+// main
@@ -0,0 +1,261 @@
+/*! \file mazeio.cpp
+	\brief Maze files
+
+	Mazes are stored in one of two formats. Maze::load detects the
+	format by the magic number of the binary format.
+
+	Text format (.maze), line oriented, # starts a comment:
+
+		maze <type> <cols> <rows>      type is white, gray or color
+		start <x> <y> <dir>            dir is east, north, west or south
+		exit <x> <y> <dir>             direction of the exit strip
+		grid                           followed by <rows> rows
+		<row rows-1>                   northern row first
+		...
+		<row 0>
+
+	Each row has one character per junction, west to east:
+	'.' no line, '-' line to the east, '|' line to the north,
+	'+' lines to the east and north.
+
+	Binary format (.mzb), little endian:
+
+		0   char[4]   magic "MZB1"
+		4   uint8     maze type
+		5   uint8     start direction
+		6   uint8     exit direction
+		7   uint8     reserved, 0
+		8   uint32    cols
+		12  uint32    rows
+		16  uint32    start x, start y
+		24  uint32    exit x, exit y
+		32  uint8[]   grid, (cols*rows+3)/4 bytes
+
+	The grid is the packed grid of Maze, two bits per junction,
+	bit 0 line east, bit 1 line north, junction (x,y) at index
+	y*cols+x, four junctions per byte starting at the low bits.
+	Binary files are mapped, not read.
+
+	\author agent
+	\version 20261016
+
+	Changelog:
+		- 20261016 agent
+			- initial version
+*/
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <cctype>
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include "maze.h"
+
+namespace sim {
+
+#define MZB_MAGIC     "MZB1"    //!< magic number of binary maze files
+#define MZB_HEADER    32        //!< size of the binary header
+
+//! \brief A mapped file, unmapped with the last maze using it
+struct Mapping {
+	void *addr;     //!< start of the mapping
+	size_t len;     //!< length of the mapping
+	Mapping (void *addr, size_t len) : addr(addr), len(len) {}
+	~Mapping (void) { munmap(addr, len); }
+};
+
+//! \brief Reads a little endian uint32
+static unsigned long get32 (const unsigned char *p)
+{
+	return p[0] | (p[1] << 8) | (p[2] << 16) | ((unsigned long)p[3] << 24);
+}
+// get32
+
+//! \brief Writes a little endian uint32
+static void put32 (unsigned char *p, unsigned long v)
+{
+	p[0] = v & 0xFF; p[1] = (v >> 8) & 0xFF; p[2] = (v >> 16) & 0xFF; p[3] = (v >> 24) & 0xFF;
+}
+// put32
+
+//! \brief Throws an error about a maze file
+static void fail (const std::string &path, const std::string &what, int line = 0)
+{
+	std::ostringstream os;
+	os << path;
+	if (line > 0) os << ":" << line;
+	os << ": " << what;
+	throw std::runtime_error(os.str());
+}
+// fail
+
+/*!
+	\brief Loads a maze file
+
+	Binary files are mapped copy-on-write, such that the maze
+	can be modified without touching the file.
+*/
+Maze Maze::load (const std::string &path)
+{
+	int fd = open(path.c_str(), O_RDONLY);
+	if (fd < 0) fail(path, strerror(errno));
+	struct stat st;
+	if (fstat(fd, &st) < 0) {
+		close(fd);
+		fail(path, strerror(errno));
+	}
+	size_t len = st.st_size;
+	char magic[4] = { 0, 0, 0, 0 };
+	if ((len >= MZB_HEADER) && (pread(fd, magic, 4, 0) == 4) && (memcmp(magic, MZB_MAGIC, 4) == 0)) {
+		try {
+			Maze maze = map(path, fd, len);
+			close(fd);
+			return maze;
+		} catch (...) {
+			close(fd);
+			throw;
+		}
+	}
+	close(fd);
+	std::ifstream in(path.c_str(), std::ios::binary);
+	std::string text((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+	if (!in.good() && !in.eof()) fail(path, "read error");
+	return parse(path, text.data(), text.size());
+}
+// load
+
+//! \brief Maps a binary maze file
+Maze Maze::map (const std::string &path, int fd, size_t len)
+{
+	void *addr = mmap(0, len, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+	if (addr == MAP_FAILED) fail(path, strerror(errno));
+	std::shared_ptr<Mapping> mapping = std::make_shared<Mapping>(addr, len);
+	const unsigned char *h = (const unsigned char *)addr;
+	int type = h[4];
+	unsigned long cols = get32(h + 8), rows = get32(h + 12);
+	if (type < MAZE_WHITE || type > MAZE_COLOR) fail(path, "unknown maze type");
+	if (cols < 1 || rows < 1 || cols * rows > 0x40000000UL) fail(path, "invalid maze size");
+	Maze maze;
+	maze.mtype = type;
+	maze.ncols = (int)cols;
+	maze.nrows = (int)rows;
+	if (len < MZB_HEADER + maze.grid_size()) fail(path, "truncated grid");
+	maze.mapping = mapping;
+	maze.grid = (unsigned char *)addr + MZB_HEADER;
+	maze.set_start((int)get32(h + 16), (int)get32(h + 20), h[5]);
+	maze.set_exit((int)get32(h + 24), (int)get32(h + 28), h[6]);
+	return maze;
+}
+// map
+
+//! \brief Parses a text maze file
+Maze Maze::parse (const std::string &path, const char *text, size_t len)
+{
+	Maze maze;
+	bool header = false, start = false, exit = false;
+	int row = -1;          // row of the grid expected next, -1 before grid
+	int lineno = 0;
+	const char *p = text, *end = text + len;
+	while (p < end) {
+		const char *eol = (const char *)memchr(p, '\n', end - p);
+		if (!eol) eol = end;
+		std::string line(p, eol);
+		p = eol + 1;
+		lineno++;
+		size_t hash = line.find('#');
+		if (hash != std::string::npos) line.erase(hash);
+		while (!line.empty() && isspace((unsigned char)line[line.size() - 1])) line.erase(line.size() - 1);
+		if (line.empty()) continue;
+		if (row >= 0) {
+			// a grid row
+			if ((int)line.size() != maze.ncols) fail(path, "row length differs from cols", lineno);
+			for (int x = 0; x < maze.ncols; x++) {
+				char c = line[x];
+				int b = (c == '.') ? 0 : (c == '-') ? LINK_EAST : (c == '|') ? LINK_NORTH : (c == '+') ? 3 : -1;
+				if (b < 0) fail(path, "invalid grid character", lineno);
+				if ((b & LINK_EAST) && (x + 1 >= maze.ncols)) fail(path, "line leaves the maze", lineno);
+				if ((b & LINK_NORTH) && (row + 1 >= maze.nrows)) fail(path, "line leaves the maze", lineno);
+				if (b) maze.set_bits(x, row, b, true);
+			}
+			row--;
+			if (row < 0) row = -2;    // grid complete
+			continue;
+		}
+		std::istringstream is(line);
+		std::string key, name;
+		is >> key;
+		if (key == "maze") {
+			int cols = 0, rows = 0;
+			is >> name >> cols >> rows;
+			if (!is || header) fail(path, "invalid maze line", lineno);
+			int type = type_of(name);
+			if (!type) fail(path, "unknown maze type " + name, lineno);
+			try {
+				maze = Maze(type, cols, rows);
+			} catch (const std::exception &e) {
+				fail(path, e.what(), lineno);
+			}
+			header = true;
+		} else if ((key == "start") || (key == "exit")) {
+			int x = -1, y = -1;
+			is >> x >> y >> name;
+			int dir = dir_of(name);
+			if (!is || !header || (dir < 0) || !maze.contains(x, y)) fail(path, "invalid " + key + " line", lineno);
+			if (key == "start") { maze.set_start(x, y, dir); start = true; }
+			else { maze.set_exit(x, y, dir); exit = true; }
+		} else if (key == "grid") {
+			if (!header || (row != -1)) fail(path, "unexpected grid", lineno);
+			row = maze.nrows - 1;
+		} else {
+			fail(path, "unknown keyword " + key, lineno);
+		}
+	}
+	if (!header) fail(path, "missing maze line");
+	if (!start) fail(path, "missing start line");
+	if (!exit) fail(path, "missing exit line");
+	if (row != -2) fail(path, "incomplete grid");
+	return maze;
+}
+// parse
+
+//! \brief Saves a maze, binary if path ends with .mzb, text otherwise
+void Maze::save (const std::string &path) const
+{
+	bool binary = (path.size() > 4) && (path.compare(path.size() - 4, 4, ".mzb") == 0);
+	std::ofstream out(path.c_str(), std::ios::binary | std::ios::trunc);
+	if (!out) fail(path, strerror(errno));
+	if (binary) {
+		unsigned char h[MZB_HEADER];
+		memset(h, 0, sizeof(h));
+		memcpy(h, MZB_MAGIC, 4);
+		h[4] = (unsigned char)mtype;
+		h[5] = (unsigned char)sdir;
+		h[6] = (unsigned char)edir;
+		put32(h + 8, ncols);
+		put32(h + 12, nrows);
+		put32(h + 16, sx);
+		put32(h + 20, sy);
+		put32(h + 24, ex);
+		put32(h + 28, ey);
+		out.write((const char *)h, sizeof(h));
+		out.write((const char *)grid, grid_size());
+	} else {
+		out << "maze " << type_name(mtype) << " " << ncols << " " << nrows << "\n";
+		out << "start " << sx << " " << sy << " " << dir_name(sdir) << "\n";
+		out << "exit " << ex << " " << ey << " " << dir_name(edir) << "\n";
+		out << "grid\n";
+		std::string line(ncols, '.');
+		for (int y = nrows - 1; y >= 0; y--) {
+			for (int x = 0; x < ncols; x++) line[x] = ".-|+"[bits(x, y)];
+			out << line << "\n";
+		}
+	}
+	if (!out) fail(path, "write error");
+}
+// save
+
+} // namespace sim
@@ -0,0 +1,116 @@
+/*! \file mazesim.cpp
+	\brief Runs the maze solver in the simulator
+
+	Usage: mazesim [-t type] [-s seed] [-l limit] [-r runs] [-a ambient] [-g glitch] [-p param=value] ... [-f image] [maze]
+
+	Runs src/maze.nxc compiled for the maze type on a maze file and
+	prints the outcome of the run. Without a maze file the built-in
+	demo maze of the given type is used. With several runs the robot
+	is put back on the start after each run, see runtime.h. Tunable
+	variables are set with -p, e.g. -p replay=2 replays the path.
+	With -f the files of the brick are loaded from a flash image, if
+	it exists, and saved to it after the run, such that a second
+	call works like switching the brick off and on again. With -a the
+	light sensor reads that many percent more, like in a brighter
+	room, which calibrate makes up for. With -g that many percent of
+	the samples read the background, like specks on the poster.
+
+	\author agent
+	\version 20261016
+
+	Changelog:
+		- 20261016 agent
+			- initial version
+			- maze files
+			- several runs
+			- parameters
+			- flash image
+			- latency of stops
+			- ambient light
+			- pose error
+			- specks, confidence of the surface
+*/
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <fstream>
+#include <string>
+#include "runtime.h"
+
+using namespace sim;
+
+//! \brief Prints usage and exits
+static void usage (void)
+{
+	fprintf(stderr, "usage: mazesim [-t white|gray|color] [-s seed] [-l limit_ms] [-r runs] [-a ambient] [-g glitch] [-p param=value] ... [-f image] [maze]\n");
+	exit(2);
+}
+// usage
+
+//! \brief Maze type of a name
+static int maze_type (const char *name)
+{
+	int type = Maze::type_of(name);
+	if (!type) usage();
+	return type;
+}
+// maze_type
+
+int main (int argc, char **argv)
+{
+	int type = MAZE_COLOR;
+	Config cfg;
+	const char *path = 0;
+	const char *image = 0;
+	Flash flash;
+	for (int i = 1; i < argc; i++) {
+		if ((strcmp(argv[i], "-t") == 0) && (i + 1 < argc)) type = maze_type(argv[++i]);
+		else if ((strcmp(argv[i], "-s") == 0) && (i + 1 < argc)) cfg.seed = strtoull(argv[++i], 0, 10);
+		else if ((strcmp(argv[i], "-l") == 0) && (i + 1 < argc)) cfg.limit = atol(argv[++i]);
+		else if ((strcmp(argv[i], "-r") == 0) && (i + 1 < argc)) cfg.runs = atoi(argv[++i]);
+		else if ((strcmp(argv[i], "-a") == 0) && (i + 1 < argc)) cfg.ambient = atof(argv[++i]);
+		else if ((strcmp(argv[i], "-g") == 0) && (i + 1 < argc)) cfg.glitch = atof(argv[++i]);
+		else if ((strcmp(argv[i], "-p") == 0) && (i + 1 < argc)) {
+			const char *eq = strchr(argv[++i], '=');
+			int param = eq ? Params::find(std::string(argv[i], eq - argv[i])) : -1;
+			if (param < 0) usage();
+			cfg.params.value[param] = atoi(eq + 1);
+		}
+		else if ((strcmp(argv[i], "-f") == 0) && (i + 1 < argc)) image = argv[++i];
+		else if ((argv[i][0] != '-') && !path) path = argv[i];
+		else usage();
+	}
+	try {
+		Maze maze = path ? Maze::load(path) : Maze::demo(type);
+		const Model &model = find_model(maze.type());
+		if (image) {
+			if (std::ifstream(image)) flash.load(image);
+			cfg.flash = &flash;
+		}
+		Runtime rt(model, maze, cfg);
+		Result r = rt.run();
+		if (image) flash.save(image);
+		printf("maze      %s\n", path ? path : "demo");
+		printf("type      %s\n", model.name);
+		printf("size      %dx%d\n", maze.cols(), maze.rows());
+		printf("seed      %llu\n", cfg.seed);
+		printf("finished  %s\n", r.finished ? "yes" : "no");
+		printf("exited    %s\n", r.exited ? "yes" : "no");
+		printf("lost      %s\n", r.lost ? "yes" : "no");
+		printf("t_exit    %ld ms\n", r.t_exit);
+		printf("t_end     %ld ms\n", r.t_end);
+		printf("distance  %.0f mm\n", r.distance);
+		printf("rotation  %.0f deg\n", r.rotation);
+		printf("turns     %d\n", r.turns);
+		if (r.stops > 0) printf("stops     %d, %lld us mean, %ld us max\n", r.stops, r.t_stops / r.stops, r.t_stop_max);
+		if (r.samples > 0) printf("surface   %d undefined, %lld %% mean confidence\n", r.undefined, r.conf / r.samples);
+		if (r.poses > 0) printf("pose      %.1f mm mean error, %.1f mm max\n", r.pose_error / r.poses, r.pose_error_max);
+		for (int i = 0; i < r.runs; i++) printf("run %d     %ld ms\n", i + 1, r.t_run[i]);
+		return r.exited ? 0 : 1;
+	} catch (const std::exception &e) {
+		fprintf(stderr, "mazesim: %s\n", e.what());
+		return 2;
+	}
+}
+// main
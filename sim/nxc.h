@@ -0,0 +1,38 @@
+/*! \file nxc.h
+	\brief NXC language constructs for the host compiler
+
+	Maps the few NXC keywords which are not C++ onto C++. Must only
+	be included by program.cpp right before src/maze.nxc, since the
+	macros would break any other C++ code.
+
+	Tasks become member functions of the program class, `start` spawns
+	a member function as simulated task. libNXC.h is not compiled, its
+	NBC routines are provided by the simulated brick.
+
+	\author agent
+	\version 20261016
+
+	Changelog:
+		- 20261016 agent
+			- initial version
+			- mutex
+			- instances of RotateBaseDegrees
+*/
+#ifndef SIM_NXC_H
+#define SIM_NXC_H 1
+
+#define NXTSIM     1                       //!< compiling for the simulator
+#define LIBNXC__H  1                       //!< skip libNXC.h, see Brick
+#define task       void                    //!< tasks are member functions
+#define until(c)   while (!(c))            //!< NXC until loop
+#define start      starter = &Self::       //!< start a task
+
+typedef sim::Byte byte;                    //!< shared between tasks
+typedef sim::Mutex mutex;                  //!< NXC mutex
+
+// each call of RotateBaseDegrees of the brick has its own locals
+#define RotateBaseDegreesInstance(_id)
+#define RotateBaseDegreesOn(_id, _ports, _pwr, _degrees, _diam, _ccdist) \
+	RotateBaseDegrees(_ports, _pwr, _degrees, _diam, _ccdist)
+
+#endif // SIM_NXC_H
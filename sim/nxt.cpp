@@ -0,0 +1,430 @@
+/*! \file nxt.cpp
+	\brief NXC API of the simulated NXT brick
+
+	\author agent
+	\version 20261016
+
+	Changelog:
+		- 20261016 agent
+			- initial version
+			- touch sensor
+			- files
+			- mutexes
+			- Sin and Cos
+			- motors of a port constant from a table
+			- Write as wide as the type of its argument
+*/
+#include <cmath>
+#include "nxt.h"
+#include "runtime.h"
+
+namespace sim {
+
+//! \brief Motors of OUT_A to OUT_ABC, like __ArrPortTable in libNBC.h, -1 past the last
+static const int port_table[OUT_ABC + 1][3] = {
+	{ OUT_A, -1, -1 }, { OUT_B, -1, -1 }, { OUT_C, -1, -1 },
+	{ OUT_A, OUT_B, -1 }, { OUT_A, OUT_C, -1 }, { OUT_B, OUT_C, -1 },
+	{ OUT_A, OUT_B, OUT_C }
+};
+
+/*!
+	\brief Motors of an output port constant
+
+	\param	ports	OUT_A to OUT_ABC
+	\param	m		Set to the motor indices
+	\return	Number of motors, 0 for no port constant
+*/
+static int motors (int ports, int m[3])
+{
+	if ((ports < OUT_A) || (ports > OUT_ABC)) return 0;
+	int n = 0;
+	while ((n < 3) && (port_table[ports][n] >= 0)) {
+		m[n] = port_table[ports][n];
+		n++;
+	}
+	return n;
+}
+// motors
+
+Byte::operator int (void) const
+{
+	Runtime::current()->cpu(COST_OP);
+	return v;
+}
+
+Brick::Brick (Runtime &rt) : rt(rt)
+{
+}
+
+Brick::~Brick (void)
+{
+}
+
+/*!
+	\brief Sets the outputs running
+
+	In sync mode the turn percentage is applied like the firmware does.
+	The first motor runs at pwr, the second one is slowed down with
+	increasing turnpct and reverses at 100. Negative turnpct swap roles.
+*/
+void Brick::run (int ports, int pwr, int regmode, int turnpct, int reset)
+{
+	int m[3] = { 0, 0, 0 };
+	int n = motors(ports, m);
+	for (int i = 0; i < n; i++) {
+		int p = pwr;
+		if ((regmode == OUT_REGMODE_SYNC) && (n == 2)) {
+			if ((turnpct > 0) && (i == 1)) p = pwr * (100 - 2 * turnpct) / 100;
+			if ((turnpct < 0) && (i == 0)) p = pwr * (100 + 2 * turnpct) / 100;
+		}
+		rt.motor_reset(m[i], reset);
+		rt.motor_run(m[i], p, regmode != OUT_REGMODE_IDLE);
+	}
+	rt.cpu(COST_OUTPUT);
+}
+// run
+
+void Brick::OnFwd (int ports, int pwr)
+{
+	run(ports, pwr, OUT_REGMODE_IDLE, 0, RESET_BLOCKANDTACHO);
+}
+
+void Brick::OnRev (int ports, int pwr)
+{
+	run(ports, -pwr, OUT_REGMODE_IDLE, 0, RESET_BLOCKANDTACHO);
+}
+
+void Brick::OnFwdEx (int ports, int pwr, int reset)
+{
+	run(ports, pwr, OUT_REGMODE_IDLE, 0, reset);
+}
+
+void Brick::OnRevEx (int ports, int pwr, int reset)
+{
+	run(ports, -pwr, OUT_REGMODE_IDLE, 0, reset);
+}
+
+void Brick::OnFwdReg (int ports, int pwr, int regmode)
+{
+	run(ports, pwr, regmode, 0, RESET_BLOCKANDTACHO);
+}
+
+void Brick::OnFwdRegEx (int ports, int pwr, int regmode, int reset)
+{
+	run(ports, pwr, regmode, 0, reset);
+}
+
+void Brick::OnFwdSync (int ports, int pwr, int turnpct)
+{
+	run(ports, pwr, OUT_REGMODE_SYNC, turnpct, RESET_BLOCKANDTACHO);
+}
+
+void Brick::OnFwdSyncEx (int ports, int pwr, int turnpct, int reset)
+{
+	run(ports, pwr, OUT_REGMODE_SYNC, turnpct, reset);
+}
+
+void Brick::OnRevSync (int ports, int pwr, int turnpct)
+{
+	run(ports, -pwr, OUT_REGMODE_SYNC, turnpct, RESET_BLOCKANDTACHO);
+}
+
+void Brick::Off (int ports)
+{
+	OffEx(ports, RESET_BLOCKANDTACHO);
+}
+
+void Brick::OffEx (int ports, int reset)
+{
+	int m[3] = { 0, 0, 0 };
+	int n = motors(ports, m);
+	for (int i = 0; i < n; i++) {
+		rt.motor_reset(m[i], reset);
+		rt.motor_off(m[i]);
+	}
+	rt.cpu(COST_OUTPUT);
+}
+
+/*!
+	\brief Rotates the outputs by angle degrees and waits until done
+
+	Like the firmware the motors brake at the tacho limit, the
+	calling task polls the run state until then.
+*/
+void Brick::RotateMotor (int ports, int pwr, long angle)
+{
+	int m[3] = { 0, 0, 0 };
+	int n = motors(ports, m);
+	if (angle < 0) { angle = -angle; pwr = -pwr; }
+	run(ports, pwr, (n == 2) ? OUT_REGMODE_SYNC : OUT_REGMODE_SPEED, 0, RESET_BLOCKANDTACHO);
+	for (int i = 0; i < n; i++) rt.motor_limit(m[i], angle);
+	for (int i = 0; i < n; i++)
+		while (MotorRunState(m[i]) == OUT_RUNSTATE_RUNNING);
+}
+// RotateMotor
+
+void Brick::ResetTachoCount (int ports)
+{
+	int m[3] = { 0, 0, 0 };
+	int n = motors(ports, m);
+	for (int i = 0; i < n; i++) rt.motor_reset(m[i], RESET_COUNT);
+	rt.cpu(COST_OUTPUT);
+}
+
+void Brick::ResetRotationCount (int ports)
+{
+	int m[3] = { 0, 0, 0 };
+	int n = motors(ports, m);
+	for (int i = 0; i < n; i++) rt.motor_reset(m[i], RESET_ROTATION_COUNT);
+	rt.cpu(COST_OUTPUT);
+}
+
+long Brick::MotorTachoCount (int port)
+{
+	rt.cpu(COST_OUTPUT);
+	return rt.motor_tacho(port & 0x03);
+}
+
+long Brick::MotorRotationCount (int port)
+{
+	rt.cpu(COST_OUTPUT);
+	return rt.motor_rotation(port & 0x03);
+}
+
+int Brick::MotorRunState (int port)
+{
+	rt.cpu(COST_OUTPUT);
+	return rt.motor_running(port & 0x03) ? OUT_RUNSTATE_RUNNING : OUT_RUNSTATE_IDLE;
+}
+
+int Brick::MotorActualSpeed (int port)
+{
+	rt.cpu(COST_OUTPUT);
+	return rt.motor_speed(port & 0x03);
+}
+
+// INPUT
+
+void Brick::SetSensorType (int port, int type)
+{
+	rt.sensor_type(port, type);
+	rt.cpu(COST_OP);
+}
+
+void Brick::SetSensorMode (int port, int mode)
+{
+	(void)port; (void)mode;
+	rt.cpu(COST_OP);
+}
+
+void Brick::SetSensorLowspeed (int port)
+{
+	SetSensorType(port, SENSOR_TYPE_LOWSPEED);
+}
+
+void Brick::SetSensorTouch (int port)
+{
+	SetSensorType(port, SENSOR_TYPE_TOUCH);
+}
+
+void Brick::ResetSensor (int port)
+{
+	(void)port;
+	rt.cpu(COST_OP);
+}
+
+/*!
+	\brief Value of an analog sensor
+
+	The light sensor reads the reflected light in percent, the
+	touch sensor is pressed when the robot has been put back on
+	the start for another run.
+*/
+int Brick::SensorValue (int port)
+{
+	rt.cpu(COST_ANALOG);
+	if (rt.sensor_type(port) == SENSOR_TYPE_LIGHT_ACTIVE) return rt.light();
+	if (rt.sensor_type(port) == SENSOR_TYPE_TOUCH) return rt.touched() ? 1 : 0;
+	return 0;
+}
+// SensorValue
+
+//! \brief Color number of the HT color sensor
+int Brick::SensorHTColorNum (int port)
+{
+	rt.cpu(COST_OP);
+	if (rt.sensor_type(port) != SENSOR_TYPE_LOWSPEED) return 0;
+	return rt.color();
+}
+// SensorHTColorNum
+
+void Brick::i2c (int port)
+{
+	(void)port;
+	rt.cpu(COST_OP);
+	rt.block(COST_I2C);
+}
+
+// FILES
+// handles of files not opened are 0xFF, like on the brick
+
+unsigned int Brick::CreateFile (const char *name, unsigned int size, Byte &handle)
+{
+	int h;
+	rt.cpu(COST_FILE);
+	unsigned int rc = rt.files().create(name, size, h);
+	handle = h;
+	return rc;
+}
+
+unsigned int Brick::OpenFileAppend (const char *name, unsigned int &size, Byte &handle)
+{
+	int h;
+	rt.cpu(COST_FILE);
+	unsigned int rc = rt.files().append(name, size, h);
+	handle = h;
+	return rc;
+}
+
+unsigned int Brick::OpenFileRead (const char *name, unsigned int &size, Byte &handle)
+{
+	int h;
+	rt.cpu(COST_FILE);
+	unsigned int rc = rt.files().read(name, size, h);
+	handle = h;
+	return rc;
+}
+
+unsigned int Brick::CloseFile (int handle)
+{
+	rt.cpu(COST_FILE);
+	return rt.files().close(handle);
+}
+
+//! \brief Reads a byte, the only type the sources read
+unsigned int Brick::Read (int handle, Byte &value)
+{
+	unsigned char v = 0;
+	rt.cpu(COST_OUTPUT);
+	unsigned int rc = rt.files().get(handle, v);
+	if (rc == LDR_SUCCESS) value = v;
+	return rc;
+}
+// Read
+
+//! \brief Writes a byte
+unsigned int Brick::Write (int handle, const Byte &value)
+{
+	return put(handle, value.raw(), 1);
+}
+// Write
+
+/*!
+	\brief Writes the low bytes of value, least significant first
+
+	Like Write of the firmware, which writes a variable as wide as
+	its type, such that only a byte variable takes one byte.
+*/
+unsigned int Brick::put (int handle, long value, int bytes)
+{
+	rt.cpu(COST_OUTPUT);
+	unsigned int rc = LDR_SUCCESS;
+	for (int i = 0; (i < bytes) && (rc == LDR_SUCCESS); i++) {
+		rc = rt.files().put(handle, (unsigned char)(value >> (8 * i)));
+	}
+	return rc;
+}
+// put
+
+// MISC
+
+void Brick::Acquire (Mutex &m)
+{
+	rt.acquire(m);
+}
+
+void Brick::Release (Mutex &m)
+{
+	rt.release(m);
+}
+
+void Brick::Wait (long ms)
+{
+	rt.block(ms * 1000);
+}
+
+unsigned long Brick::CurrentTick (void)
+{
+	rt.cpu(COST_OP);
+	return (unsigned long)(rt.now() / 1000);
+}
+
+void Brick::PlayToneEx (int freq, int ms, int vol, bool loop)
+{
+	(void)freq; (void)ms; (void)vol; (void)loop;
+	rt.cpu(COST_OUTPUT);
+}
+
+/*!
+	\brief Sine of an angle in degrees, scaled by 100
+
+	Like NXC on the standard firmware, which has no floats, the
+	result is an integer from -100 to 100.
+*/
+int Brick::Sin (int degrees)
+{
+	rt.cpu(2 * COST_OP);
+	return (int)std::floor(100 * std::sin(degrees * M_PI / 180) + 0.5);
+}
+// Sin
+
+//! \brief Cosine of an angle in degrees, scaled by 100, see Sin
+int Brick::Cos (int degrees)
+{
+	rt.cpu(2 * COST_OP);
+	return (int)std::floor(100 * std::cos(degrees * M_PI / 180) + 0.5);
+}
+// Cos
+
+// LIBRARY
+
+/*!
+	\brief Rotate motor(s) such that wheel(s) turn a number of mm.
+
+	Same as __RotateMotorMm in libNBC.h with variable arguments, the
+	simulator does not fold constants.
+*/
+unsigned long Brick::RotateMotorMm (int ports, int pwr, int mm, unsigned int circ)
+{
+	rt.cpu(4 * COST_OP);
+	long degrees = (mm * 360) / (long)circ;
+	RotateMotor(ports, pwr, degrees);
+	return degrees;
+}
+// RotateMotorMm
+
+/*!
+	\brief Rotate two parallel wheels such that they turn on a base circle a number of degrees.
+
+	Same as __RotateBaseDegrees in libNBC.h, the wheels turn relative
+	to their rotation counts at the start, which are not reset.
+*/
+long Brick::RotateBaseDegrees (int ports, int pwr, int degrees, unsigned int diam, unsigned int ccdist)
+{
+	int m[3] = { 0, 0, 0 };
+	motors(ports, m);
+	rt.cpu(8 * COST_OP);
+	int turnpct = (degrees >= 0) ? 100 : -100;
+	long target = (abs(degrees) * (long)ccdist) / (long)diam;
+	long from0 = MotorRotationCount(m[0]);
+	long from1 = MotorRotationCount(m[1]);
+	OnFwdSync(ports, pwr, turnpct);
+	while ((labs(MotorRotationCount(m[0]) - from0) < target) || (labs(MotorRotationCount(m[1]) - from1) < target));
+	Off(ports);
+	long turned = labs(MotorRotationCount(m[0]) - from0) + labs(MotorRotationCount(m[1]) - from1);
+	rt.cpu(6 * COST_OP);
+	return (turned * (long)diam * turnpct) / ((long)ccdist * 200);
+}
+// RotateBaseDegrees
+
+} // namespace sim
@@ -0,0 +1,212 @@
+/*! \file nxt.h
+	\brief NXC API of the simulated NXT brick
+
+	Provides the subset of the NXC API used by the sources in src/
+	as members of the class Brick. A program compiled for the simulator
+	derives from Brick, such that calls like OnFwdReg or SensorValue
+	resolve to the simulated brick of that program. Every call charges
+	the VM time it takes on the real brick to the calling task.
+
+	The constants are the same as in the NBC/NXC headers such that
+	the sources compile unmodified.
+
+	\author agent
+	\version 20261016
+
+	Changelog:
+		- 20261016 agent
+			- initial version
+			- files
+			- mutexes
+			- Sin and Cos
+*/
+#ifndef SIM_NXT_H
+#define SIM_NXT_H 1
+
+#include <cstdlib>
+#include <deque>
+
+// BOOL
+#define TRUE     1
+#define FALSE    0
+
+// INPUT PORTS
+#define IN_1    0x00    //!< input port 1
+#define IN_2    0x01    //!< input port 2
+#define IN_3    0x02    //!< input port 3
+#define IN_4    0x03    //!< input port 4
+
+// OUTPUT PORTS
+#define OUT_A      0x00    //!< output port A
+#define OUT_B      0x01    //!< output port B
+#define OUT_C      0x02    //!< output port C
+#define OUT_AB     0x03    //!< output ports A and B
+#define OUT_AC     0x04    //!< output ports A and C
+#define OUT_BC     0x05    //!< output ports B and C
+#define OUT_ABC    0x06    //!< output ports A, B and C
+
+// OUTPUT MODULE
+#define OUT_REGMODE_IDLE        0x00    //!< no regulation
+#define OUT_REGMODE_SPEED       0x01    //!< speed regulation
+#define OUT_REGMODE_SYNC        0x02    //!< synchronization
+#define OUT_RUNSTATE_IDLE       0x00    //!< motor is idle
+#define OUT_RUNSTATE_RUNNING    0x20    //!< motor is running
+#define RESET_NONE              0x00    //!< no counter reset
+#define RESET_COUNT             0x08    //!< reset the tacho count
+#define RESET_BLOCK_COUNT       0x20    //!< reset the block tacho count
+#define RESET_ROTATION_COUNT    0x40    //!< reset the rotation count
+#define RESET_BLOCKANDTACHO     0x28    //!< reset the block and tacho count
+#define RESET_ALL               0x68    //!< reset all counters
+
+// INPUT MODULE
+#define SENSOR_TYPE_NONE            0x00    //!< no sensor
+#define SENSOR_TYPE_TOUCH           0x01    //!< touch sensor
+#define SENSOR_TYPE_LIGHT_ACTIVE    0x05    //!< light sensor, led on
+#define SENSOR_TYPE_LOWSPEED        0x0A    //!< I2C sensor
+#define SENSOR_MODE_RAW             0x00    //!< raw values
+#define SENSOR_MODE_BOOL            0x20    //!< boolean values
+#define SENSOR_MODE_PERCENT         0x80    //!< percentage values
+
+namespace sim {
+
+class Runtime;
+
+/*!
+	\brief A byte shared between tasks
+
+	NXC programs communicate between tasks through global variables
+	and busy-wait on them, e.g. while (surface == SURFACE_LINE);
+	Reading a Byte charges one VM op to the reading task, which
+	gives the other tasks the chance to run and change it.
+*/
+class Byte
+{
+public:
+	Byte (void) : v(0) {}
+	Byte (int x) : v((unsigned char)x) {}
+	operator int (void) const;
+	unsigned char raw (void) const { return v; }    //!< read without charging VM time
+private:
+	unsigned char v;
+};
+
+/*!
+	\brief An NXC mutex
+
+	Acquire blocks the calling task while another task owns the
+	mutex. Like the firmware, Release hands the mutex over to the
+	task waiting longest, which then runs with the next slice.
+*/
+class Mutex
+{
+public:
+	Mutex (void) : owner(-1) {}
+private:
+	friend class Runtime;
+	int owner;                 //!< task owning the mutex, -1 if none
+	std::deque<int> waiting;   //!< tasks blocked in Acquire, first come first
+};
+
+/*!
+	\brief The NXC API of the simulated brick
+
+	Members are named after the NXC API functions. Output
+	ports can be single ports or port groups like OUT_AC.
+*/
+class Brick
+{
+public:
+	explicit Brick (Runtime &rt);
+	virtual ~Brick (void);
+
+	// OUTPUT
+	void OnFwd (int ports, int pwr);
+	void OnRev (int ports, int pwr);
+	void OnFwdEx (int ports, int pwr, int reset);
+	void OnRevEx (int ports, int pwr, int reset);
+	void OnFwdReg (int ports, int pwr, int regmode);
+	void OnFwdRegEx (int ports, int pwr, int regmode, int reset);
+	void OnFwdSync (int ports, int pwr, int turnpct);
+	void OnFwdSyncEx (int ports, int pwr, int turnpct, int reset);
+	void OnRevSync (int ports, int pwr, int turnpct);
+	void Off (int ports);
+	void OffEx (int ports, int reset);
+	void RotateMotor (int ports, int pwr, long angle);
+	void ResetTachoCount (int ports);
+	void ResetRotationCount (int ports);
+	long MotorTachoCount (int port);
+	long MotorRotationCount (int port);
+	int MotorRunState (int port);
+	int MotorActualSpeed (int port);
+
+	// INPUT
+	void SetSensorType (int port, int type);
+	void SetSensorMode (int port, int mode);
+	void SetSensorLowspeed (int port);
+	void SetSensorTouch (int port);
+	void ResetSensor (int port);
+	int SensorValue (int port);
+	int SensorHTColorNum (int port);
+
+	/*!
+		\brief Writes and reads an I2C device
+
+		The only I2C device besides the color sensor is the HT prototype
+		board which drives the debugging LEDs. The transaction is timed
+		but has no effect.
+	*/
+	template <typename B, typename C, typename R>
+	bool I2CBytes (int port, B &inbuf, C &count, R &outbuf)
+	{
+		(void)inbuf; (void)outbuf;
+		i2c(port);
+		count = 0;
+		return true;
+	}
+
+	// FILES
+	unsigned int CreateFile (const char *name, unsigned int size, Byte &handle);
+	unsigned int OpenFileAppend (const char *name, unsigned int &size, Byte &handle);
+	unsigned int OpenFileRead (const char *name, unsigned int &size, Byte &handle);
+	unsigned int CloseFile (int handle);
+	unsigned int Read (int handle, Byte &value);
+	unsigned int Write (int handle, const Byte &value);
+	//! \brief Writes value as wide as NXC stores its type, an int takes two bytes
+	template <typename T> unsigned int Write (int handle, T value)
+	{
+		return put(handle, (long)value, (sizeof(T) == 1) ? 1 : (sizeof(T) <= sizeof(int)) ? 2 : 4);
+	}
+
+	// MISC
+	void Acquire (Mutex &m);
+	void Release (Mutex &m);
+	void Wait (long ms);
+	unsigned long CurrentTick (void);
+	void PlayToneEx (int freq, int ms, int vol, bool loop);
+	static long abs (long x) { return (x < 0) ? -x : x; }
+	int Sin (int degrees);
+	int Cos (int degrees);
+
+	//! \brief Initializes the elements of a fixed size array
+	template <typename T, int N, typename V>
+	void ArrayInit (T (&arr)[N], V value, int n)
+	{
+		for (int i = 0; i < N && i < n; i++) arr[i] = value;
+	}
+
+	// LIBRARY
+	unsigned long RotateMotorMm (int ports, int pwr, int mm, unsigned int circ);
+	long RotateBaseDegrees (int ports, int pwr, int degrees, unsigned int diam, unsigned int ccdist);
+
+protected:
+	Runtime &rt;    //!< the runtime this brick lives in
+
+private:
+	void run (int ports, int pwr, int regmode, int turnpct, int reset);
+	void i2c (int port);
+	unsigned int put (int handle, long value, int bytes);
+};
+
+} // namespace sim
+
+#endif // SIM_NXT_H
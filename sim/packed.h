@@ -0,0 +1,53 @@
+/*! \file packed.h
+	\brief src/grid.h compiled for the host
+
+	The bit-packed grid of the brick as a C++ class, such that the
+	simulator and its tools use the same code as the brick. Unlike
+	in the simulated program, bytes are plain bytes which charge no
+	VM time, so the grid can be used outside of a simulation.
+
+	\author agent
+	\version 20261016
+
+	Changelog:
+		- 20261016 agent
+			- initial version
+*/
+#ifndef SIM_PACKED_H
+#define SIM_PACKED_H 1
+
+namespace sim {
+
+/*!
+	\brief The junctions of a maze, four bits each
+
+	All functions of src/grid.h are members.
+*/
+class PackedGrid
+{
+public:
+	typedef unsigned char byte;    //!< a plain byte
+
+	PackedGrid (void) { grid_init(); }
+
+	//! \brief Initializes the elements of a fixed size array
+	template <typename T, int N, typename V>
+	static void ArrayInit (T (&arr)[N], V value, int n)
+	{
+		for (int i = 0; i < N && i < n; i++) arr[i] = value;
+	}
+
+#ifndef NXTSIM
+#define NXTSIM 1
+#define SIM_PACKED_NXTSIM 1
+#endif
+#include "grid.h"
+#ifdef SIM_PACKED_NXTSIM
+#undef NXTSIM
+#undef SIM_PACKED_NXTSIM
+#endif
+};
+
+} // namespace sim
+
+#endif // SIM_PACKED_H
@@ -0,0 +1,132 @@
+/*! \file program.cpp
+	\brief The maze solver compiled for the simulator
+
+	Compiled once per maze type with MAZE_TYPE set to the type and
+	SIM_MODEL set to the name of the exported Model, see Makefile.
+
+	\author agent
+	\version 20261016
+
+	Changelog:
+		- 20261016 agent
+			- initial version
+			- names of the states
+			- tunable parameters
+			- replay parameter
+			- solver parameter
+			- line following parameters
+			- observed surface
+			- sample period
+			- tline of the color maze
+			- calibration parameter, thresholds of all maze types
+			- pose by odometry
+			- roll parameter
+*/
+#include "runtime.h"
+#include "program.h"
+
+#ifndef SIM_MODEL
+#error "SIM_MODEL must name the exported model"
+#endif
+
+namespace {
+
+#include "nxc.h"
+
+/*!
+	\brief src/maze.nxc as a class
+
+	All globals of maze.nxc become members, all functions and tasks
+	become member functions. This keeps concurrent simulations apart.
+*/
+class Nxc : public sim::Program
+{
+public:
+	typedef Nxc Self;
+
+	explicit Nxc (sim::Runtime &rt) : sim::Program(rt) { starter.self = this; }
+	void run (void) { main(); }
+	int current_state (void) const { return state; }
+
+	//! \brief Sets the tunable variables, parameters that are kept get the compiled value
+	void tune (sim::Params &p)
+	{
+		set(p.value[PARAM_SPEED], speed);
+		set(p.value[PARAM_SWEEP], sweep);
+		set(p.value[PARAM_CENTER], center);
+		set(p.value[PARAM_REPLAY], replay);
+		set(p.value[PARAM_SOLVER], solver);
+		set(p.value[PARAM_CRUISE], cruise);
+		set(p.value[PARAM_TEDGE], tedge);
+		set(p.value[PARAM_KP], kp);
+		set(p.value[PARAM_KI], ki);
+		set(p.value[PARAM_KD], kd);
+		set(p.value[PARAM_PERIOD], period);
+		set(p.value[PARAM_CALIB], calib);
+		set(p.value[PARAM_ROLL], roll);
+		set(p.value[PARAM_RAMP], ramp);
+		set(p.value[PARAM_GLANCE], glance);
+		set(p.value[PARAM_TJUNC], tjunc);
+		set(p.value[PARAM_TLINE], tline);
+		set(p.value[PARAM_TNDEF], tndef);
+	}
+
+	static void set (int &param, int &var)
+	{
+		if (param == PARAM_KEEP) param = var;
+		else var = param;
+	}
+
+	//! \brief Spawns a member function as task, used by `start`
+	struct Starter {
+		Self *self;
+		void operator= (void (Self::*fn)(void))
+		{
+			Self *s = self;
+			s->rt.spawn([s, fn]() { (s->*fn)(); });
+		}
+	} starter;
+
+#include "maze.nxc"
+
+	int current_surface (void) const { return (surface.raw() == SURFACE_NDEF) ? 0 : surface.raw(); }
+	int current_conf (void) const { return surface_conf; }
+	void current_pose (double &x, double &y, double &heading) const
+	{
+		x = pose_x / (double)POSE_SCALE;
+		y = pose_y / (double)POSE_SCALE;
+		heading = pose_heading / 10.0;
+	}
+};
+
+sim::Program *create (sim::Runtime &rt)
+{
+	return new Nxc(rt);
+}
+
+const sim::State states[] = {
+	{ STATE_NDEF, "ndef" },
+	{ STATE_LINE, "line" },
+	{ STATE_JUNC, "junc" },
+	{ STATE_LOOK, "look" },
+	{ STATE_EXIT, "exit" },
+	{ STATE_FINISH, "finish" },
+	{ STATE_INIT, "init" },
+	{ 0, 0 }
+};
+
+} // namespace
+
+namespace sim {
+
+extern const Model SIM_MODEL;
+const Model SIM_MODEL = {
+	MAZE_TYPE,
+	(MAZE_TYPE == MAZE_WHITE) ? "white" : (MAZE_TYPE == MAZE_GRAY) ? "gray" : "color",
+	{ LEN_JUNC, WID_JUNC, LEN_LINE, WID_LINE },
+	{ DIAM, CIRC, CDIST, SDIST },
+	states,
+	create
+};
+
+} // namespace sim
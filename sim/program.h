@@ -0,0 +1,117 @@
+/*! \file program.h
+	\brief The maze solver compiled for the simulator
+
+	program.cpp includes src/maze.nxc into a class derived from
+	Program. It is compiled once per maze type, MAZE_TYPE is the type
+	world.h assumes until calibrate tells the type of the poster.
+	Each compilation exports a Model which describes the maze type
+	and robot metrics the program was compiled with and creates
+	instances of the program.
+
+	\author agent
+	\version 20261016
+
+	Changelog:
+		- 20261016 agent
+			- initial version
+			- names of the states
+			- tunable parameters
+			- replay parameter
+			- solver parameter
+			- line following parameters
+			- observed surface
+			- sample period
+			- calibration parameter
+			- pose by odometry
+			- roll parameter
+			- ramp parameter
+*/
+#ifndef SIM_PROGRAM_H
+#define SIM_PROGRAM_H 1
+
+#include "nxt.h"
+#include <string>
+#include "maze.h"
+
+namespace sim {
+
+// PARAMETERS
+// tunable variables of maze.nxc and world.h
+#define PARAM_SPEED     0x00        //!< speed
+#define PARAM_SWEEP     0x01        //!< sweep, degrees to turn right in look
+#define PARAM_CENTER    0x02        //!< center, degrees to turn after hitting a line
+#define PARAM_TJUNC     0x03        //!< tjunc, light threshold for junctions
+#define PARAM_TLINE     0x04        //!< tline, light threshold for lines
+#define PARAM_TNDEF     0x05        //!< tndef, light threshold for undefined
+#define PARAM_REPLAY    0x06        //!< replay, REPLAY_LEARNED, REPLAY_MAP or REPLAY_PATH
+#define PARAM_SOLVER    0x07        //!< solver, SOLVER_RIGHT, SOLVER_TREMAUX or SOLVER_FLOOD
+#define PARAM_CRUISE    0x08        //!< cruise, speed following a line
+#define PARAM_TEDGE     0x09        //!< tedge, light at the edge of a line
+#define PARAM_KP        0x0A        //!< kp, proportional gain following a line
+#define PARAM_KI        0x0B        //!< ki, integral gain following a line
+#define PARAM_KD        0x0C        //!< kd, derivative gain following a line
+#define PARAM_PERIOD    0x0D        //!< period, ms between two samples of observe
+#define PARAM_CALIB     0x0E        //!< calib, 0 keeps the compiled maze type and light thresholds
+#define PARAM_ROLL      0x0F        //!< roll, 0 stops at each junction when replaying
+#define PARAM_RAMP      0x10        //!< ramp, mm before a junction from where line slows down
+#define PARAM_GLANCE    0x11        //!< glance, degrees short of a heading a line is looked for in look, half of it past
+#define PARAM_COUNT     0x12        //!< number of parameters
+#define PARAM_KEEP      (-32768)    //!< keeps the compiled value
+
+//! \brief Values of the tunable variables
+struct Params {
+	int value[PARAM_COUNT];    //!< value or PARAM_KEEP, indexed by PARAM_*
+	Params (void);
+	static const char *name (int param);
+	static int find (const std::string &name);
+};
+
+//! \brief Metrics of the robot, see robot.h
+struct RobotMetrics {
+	int diam;     //!< DIAM
+	int circ;     //!< CIRC
+	int cdist;    //!< CDIST
+	int sdist;    //!< SDIST
+};
+
+/*!
+	\brief An NXC program running on a simulated brick
+*/
+class Program : public Brick
+{
+public:
+	explicit Program (Runtime &rt) : Brick(rt) {}
+	virtual void run (void) = 0;              //!< task main
+	virtual int current_state (void) const = 0;  //!< the state of the state machine
+	virtual int current_surface (void) const = 0;  //!< the surface observed, 0 if undefined
+	virtual int current_conf (void) const = 0;     //!< percent of the samples which agree with the surface
+	virtual void current_pose (double &x, double &y, double &heading) const = 0;  //!< pose.h pose in mm and degrees
+	virtual void tune (Params &p) = 0;           //!< sets parameters, returns the values used
+};
+
+//! \brief A state of the state machine
+struct State {
+	int id;                 //!< STATE_* number
+	const char *name;       //!< lower case name
+};
+
+//! \brief A compiled program and the metrics it was compiled with
+struct Model {
+	int maze_type;          //!< MAZE_TYPE
+	const char *name;       //!< name of the maze type
+	WorldMetrics world;     //!< world.h metrics
+	RobotMetrics robot;     //!< robot.h metrics
+	const State *states;    //!< states of the state machine, ends with a null name
+	Program *(*create) (Runtime &rt);    //!< creates an instance of the program
+};
+
+extern const Model model_white;    //!< maze.nxc compiled for MAZE_WHITE
+extern const Model model_gray;     //!< maze.nxc compiled for MAZE_GRAY
+extern const Model model_color;    //!< maze.nxc compiled for MAZE_COLOR
+
+const Model &find_model (int maze_type);
+int find_state (const Model &model, const std::string &name);
+
+} // namespace sim
+
+#endif // SIM_PROGRAM_H
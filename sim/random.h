@@ -0,0 +1,65 @@
+/*! \file random.h
+	\brief Random numbers which are the same on every host
+
+	xorshift64* seeded through splitmix64. Does not depend on the
+	distributions of the standard library, such that simulations
+	and generated mazes are reproducible from their seed.
+
+	\author agent
+	\version 20261016
+
+	Changelog:
+		- 20261016 agent
+			- initial version
+*/
+#ifndef SIM_RANDOM_H
+#define SIM_RANDOM_H 1
+
+namespace sim {
+
+class Random
+{
+public:
+	explicit Random (unsigned long long seed)
+	{
+		// splitmix64, never yields a zero state
+		unsigned long long z = seed + 0x9E3779B97F4A7C15ULL;
+		z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+		z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+		state = (z ^ (z >> 31)) | 1;
+	}
+
+	//! \brief Next 64 random bits
+	unsigned long long next (void)
+	{
+		state ^= state >> 12;
+		state ^= state << 25;
+		state ^= state >> 27;
+		return state * 0x2545F4914F6CDD1DULL;
+	}
+
+	//! \brief Random number in [0,n)
+	unsigned int below (unsigned int n)
+	{
+		return (unsigned int)(((next() >> 32) * n) >> 32);
+	}
+
+	//! \brief Random number in [0,1)
+	double uniform (void)
+	{
+		return (next() >> 11) * (1.0 / 9007199254740992.0);
+	}
+
+	//! \brief Random number in [-1,1)
+	double symmetric (void)
+	{
+		return 2 * uniform() - 1;
+	}
+
+private:
+	unsigned long long state;    //!< generator state
+};
+
+} // namespace sim
+
+#endif // SIM_RANDOM_H
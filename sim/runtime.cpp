@@ -0,0 +1,632 @@
+/*! \file runtime.cpp
+	\brief Runtime of the simulated NXT brick
+
+	\author agent
+	\version 20261016
+
+	Changelog:
+		- 20261016 agent
+			- initial version
+			- time spent in and entries into each state
+			- tunable parameters
+			- several runs on the same maze
+			- flash files
+			- exit reached by the sensor spot
+			- mutexes
+			- latency of stops after a change of the surface
+			- error of the pose of the program
+			- the drive run on for a change of the surface counts as a stop
+			- each change of the spot timed by one stop only
+			- visits of each state from a transition into it to the next one
+*/
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <stdexcept>
+#include "runtime.h"
+
+namespace sim {
+
+#define TASK_STACK    (256 * 1024)    //!< bytes of stack per task
+
+static thread_local Runtime *active = 0;     //!< runtime of this thread
+
+static const char *param_names[PARAM_COUNT] = {
+	"speed", "sweep", "center", "tjunc", "tline", "tndef", "replay", "solver",
+	"cruise", "tedge", "kp", "ki", "kd", "period", "calib", "roll", "ramp",
+	"glance"
+};
+
+Params::Params (void)
+{
+	for (int i = 0; i < PARAM_COUNT; i++) value[i] = PARAM_KEEP;
+}
+
+//! \brief Name of a parameter, the name of the variable
+const char *Params::name (int param)
+{
+	return param_names[param];
+}
+// name
+
+//! \brief Parameter of a name, -1 if unknown
+int Params::find (const std::string &name)
+{
+	for (int i = 0; i < PARAM_COUNT; i++)
+		if (name == param_names[i]) return i;
+	return -1;
+}
+// find
+
+Config::Config (void)
+	: seed(1), limit(600000), grace(2000),
+	  heading_error(2.0), wheel_bias(0.01), light_noise(1.0), ambient(0), glitch(0), runs(1), flash(0)
+{
+}
+
+Result::Result (void)
+	: finished(false), exited(false), lost(false), t_exit(0), t_end(0),
+	  distance(0), rotation(0), turns(0), resets(0), runs(0), stops(0), t_stops(0), t_stop_max(0), undefined(0), samples(0), conf(0),
+	  poses(0), pose_error(0), pose_error_max(0)
+{
+	for (int i = 0; i < STATE_SLOTS; i++) {
+		t_state[i] = 0;
+		r_state[i] = 0;
+		entered[i] = 0;
+		visits[i] = 0;
+		t_visits[i] = 0;
+	}
+	for (int i = 0; i < RUNS_MAX; i++) t_run[i] = 0;
+}
+
+Runtime::Runtime (const Model &model, const Maze &maze, const Config &cfg)
+	: model(model), world(find_model(maze.type()).world), maze(maze), cfg(cfg), program(0), cur(0),
+	  clock(0), slice(0), phys(0), stop(false), analog(0), speck(false), spinning(false),
+	  rng(cfg.seed), state(0), observed(0), since(0), entry(false),
+	  run_no(0), run_start(0), reached(false), t_reached(0), touch_until(0),
+	  kind(-1), t_kind(0), t_drive(0), t_stopped(-1), drive_surface(0),
+	  flash(cfg.flash ? cfg.flash : &own)
+{
+	for (int i = 0; i < STATE_SLOTS; i++) {
+		t_state[i] = 0;
+		t_visits[i] = 0;
+	}
+	for (int m = 0; m < MOTOR_COUNT; m++) {
+		Motor &mo = motors[m];
+		mo.power = 0; mo.running = false; mo.reset = 0; mo.limit = 0;
+		mo.speed = 0; mo.tacho = 0; mo.rotation = 0;
+	}
+	for (int i = 0; i < 4; i++) types[i] = SENSOR_TYPE_NONE;
+	place();
+	double bias = rng.symmetric() * cfg.wheel_bias;
+	circl = model.robot.circ * (1 + bias);
+	circr = model.robot.circ * (1 - bias);
+	double l;
+	sample(l);
+	analog = std::max(0, std::min(100, (int)std::floor(l + cfg.ambient + 0.5)));
+}
+// Runtime
+
+Runtime::~Runtime (void)
+{
+	flash->close_all();
+	for (size_t i = 0; i < tasks.size(); i++) delete tasks[i];
+	delete program;
+}
+// ~Runtime
+
+//! \brief Places the axis on the start junction, slightly off the line direction
+void Runtime::place (void)
+{
+	double p = maze.pitch(world);
+	x = (maze.start_x() + 1) * p;
+	y = (maze.start_y() + 1) * p;
+	heading = (maze.start_dir() * 90.0 + rng.symmetric() * cfg.heading_error) * M_PI / 180.0;
+}
+// place
+
+//! \brief The runtime running on this thread
+Runtime *Runtime::current (void)
+{
+	return active;
+}
+// current
+
+/*!
+	\brief Runs the program until it returns or the run is stopped
+
+	The run stops when task main returns, the simulated time limit
+	is reached, the grace period after reaching the exit is over or
+	the robot has left the poster.
+*/
+Result Runtime::run (void)
+{
+	Runtime *outer = active;
+	active = this;
+	program = model.create(*this);
+	program->tune(cfg.params);
+	res.params = cfg.params;
+	state = program->current_state();
+	since = clock;
+	Program *p = program;
+	spawn([p]() { p->run(); });
+	cur = 0;
+	swapcontext(&host, &tasks[0]->ctx);
+	active = outer;
+	account();
+	t_state[state % STATE_SLOTS] += clock - since;
+	for (int i = 0; i < STATE_SLOTS; i++) {
+		res.t_state[i] = (long)(t_state[i] / 1000);
+		res.t_visits[i] = (long)(t_visits[i] / 1000);
+	}
+	res.t_end = clock / 1000;
+	return res;
+}
+// run
+
+//! \brief Creates a task, it is scheduled after the running tasks
+void Runtime::spawn (const std::function<void(void)> &fn)
+{
+	Task *t = new Task;
+	t->stack.resize(TASK_STACK);
+	t->fn = fn;
+	t->wake = clock;
+	t->done = false;
+	getcontext(&t->ctx);
+	t->ctx.uc_stack.ss_sp = &t->stack[0];
+	t->ctx.uc_stack.ss_size = t->stack.size();
+	t->ctx.uc_link = &host;
+	makecontext(&t->ctx, trampoline, 0);
+	tasks.push_back(t);
+}
+// spawn
+
+//! \brief Entry of all tasks
+void Runtime::trampoline (void)
+{
+	Runtime *rt = active;
+	Task *t = rt->tasks[rt->cur];
+	t->fn();
+	t->done = true;
+	if (rt->cur == 0) {
+		// task main returned, the program is done
+		rt->res.finished = true;
+		setcontext(&rt->host);
+	}
+	rt->schedule();
+}
+// trampoline
+
+/*!
+	\brief Charges VM time to the running task
+
+	Switches to the next ready task when the time slice is used up.
+	State changes of the program are noticed here, before the time
+	is charged, since a task calls the API right after changing it.
+*/
+void Runtime::cpu (long us)
+{
+	account();
+	clock += us;
+	slice += us;
+	advance();
+	if (stop) swapcontext(&tasks[cur]->ctx, &host);
+	if (slice >= TIME_SLICE) schedule();
+}
+// cpu
+
+//! \brief Accounts the time spent in the state of the program when it changes, and the changes of its surface to undefined
+void Runtime::account (void)
+{
+	int u = program->current_surface();
+	if ((u == 0) && (observed != 0)) res.undefined++;
+	observed = u;
+	int s = program->current_state();
+	if (s == state) return;
+	t_state[state % STATE_SLOTS] += clock - since;
+	if (entry) {
+		t_visits[state % STATE_SLOTS] += clock - since;
+		res.visits[state % STATE_SLOTS]++;
+	}
+	res.entered[s % STATE_SLOTS]++;
+	entry = true;
+	state = s;
+	since = clock;
+}
+// account
+
+//! \brief Blocks the running task, other tasks run meanwhile
+void Runtime::block (long us)
+{
+	tasks[cur]->wake = clock + us;
+	schedule();
+}
+// block
+
+/*!
+	\brief Acquires a mutex, blocks the running task while another task owns it
+*/
+void Runtime::acquire (Mutex &m)
+{
+	cpu(COST_OP);
+	if ((m.owner < 0) || (m.owner == (int)cur)) {
+		m.owner = (int)cur;
+		return;
+	}
+	m.waiting.push_back((int)cur);
+	tasks[cur]->wake = LLONG_MAX;
+	schedule();
+}
+// acquire
+
+//! \brief Releases a mutex owned by the running task, the task waiting longest gets it
+void Runtime::release (Mutex &m)
+{
+	cpu(COST_OP);
+	if (m.owner != (int)cur) return;
+	if (m.waiting.empty()) {
+		m.owner = -1;
+		return;
+	}
+	m.owner = m.waiting.front();
+	m.waiting.pop_front();
+	tasks[m.owner]->wake = clock;
+}
+// release
+
+/*!
+	\brief Runs the next ready task round robin
+
+	The running task is the last candidate. If no task is ready
+	the VM idles until the first one wakes. Tasks which can never
+	wake, all waiting for mutexes, stop the run.
+*/
+void Runtime::schedule (void)
+{
+	size_t n = tasks.size();
+	for (;;) {
+		for (size_t k = 1; k <= n; k++) {
+			size_t i = (cur + k) % n;
+			Task *t = tasks[i];
+			if (t->done || (t->wake > clock)) continue;
+			slice = 0;
+			if (i != cur) {
+				size_t prev = cur;
+				cur = i;
+				swapcontext(&tasks[prev]->ctx, &t->ctx);
+			}
+			return;
+		}
+		long long next = LLONG_MAX;
+		for (size_t i = 0; i < n; i++)
+			if (!tasks[i]->done && (tasks[i]->wake < next)) next = tasks[i]->wake;
+		if (next == LLONG_MAX) stop = true;
+		else {
+			clock = next;
+			advance();
+		}
+		if (stop) swapcontext(&tasks[cur]->ctx, &host);
+	}
+}
+// schedule
+
+//! \brief Updates the world up to the current time
+void Runtime::advance (void)
+{
+	while (phys + TIME_TICK <= clock) {
+		phys += TIME_TICK;
+		tick();
+	}
+	if (clock >= cfg.limit * 1000LL) stop = true;
+	// the robot is picked up when it has stopped after the exit
+	if (reached && (clock >= t_reached + cfg.grace * 1000LL)) {
+		bool idle = !motors[OUT_A].running && !motors[OUT_C].running;
+		if ((run_no + 1 >= cfg.runs) || (run_no + 1 >= RUNS_MAX)) stop = true;
+		else if (idle) restart();
+		else if (clock >= t_reached + TIME_PICKUP) stop = true;
+	}
+}
+// advance
+
+//! \brief Puts the robot back on the start and presses the touch sensor
+void Runtime::restart (void)
+{
+	run_no++;
+	place();
+	run_start = clock;
+	reached = false;
+	touch_until = clock + TIME_TOUCH;
+}
+// restart
+
+/*!
+	\brief One update of the output module and the robot pose
+
+	Pending counter resets take effect first, like on the brick,
+	where they are applied with the next output module update.
+*/
+void Runtime::tick (void)
+{
+	const double dt = TIME_TICK / 1e6;
+	for (int m = 0; m < MOTOR_COUNT; m++) {
+		Motor &mo = motors[m];
+		if (mo.reset & RESET_COUNT) mo.tacho = 0;
+		if (mo.reset & RESET_ROTATION_COUNT) mo.rotation = 0;
+		mo.reset = 0;
+		double target = mo.running ? mo.power * MOTOR_DEGPERPWR : 0;
+		double tau = mo.running ? MOTOR_TAURUN : MOTOR_TAUBRAKE;
+		mo.speed += (target - mo.speed) * (1 - std::exp(-dt / tau));
+		mo.tacho += mo.speed * dt;
+		mo.rotation += mo.speed * dt;
+		if (mo.running && (mo.limit > 0) && (std::fabs(mo.tacho) >= mo.limit)) {
+			mo.running = false;
+			mo.power = 0;
+			mo.limit = 0;
+		}
+	}
+	// differential drive, left wheel on OUT_A, right wheel on OUT_C
+	double vl = motors[OUT_A].speed * circl / 360.0;
+	double vr = motors[OUT_C].speed * circr / 360.0;
+	double v = (vl + vr) / 2;
+	double w = (vr - vl) / model.robot.cdist;
+	double h = heading + w * dt / 2;
+	x += v * std::cos(h) * dt;
+	y += v * std::sin(h) * dt;
+	heading += w * dt;
+	res.distance += std::fabs(v) * dt;
+	res.rotation += std::fabs(w) * dt * 180.0 / M_PI;
+	res.r_state[state % STATE_SLOTS] += std::fabs(w) * dt * 180.0 / M_PI;
+	bool spin = (vl * vr < 0) && (std::fabs(w) > 0.5);
+	if (spin && !spinning) res.turns++;
+	spinning = spin;
+	// sensors
+	int k = maze.kind(world, x + model.robot.sdist * std::cos(heading), y + model.robot.sdist * std::sin(heading));
+	if (k != kind) {
+		kind = k;
+		t_kind = phys;
+	}
+	if (!reached && (spot(KIND_EXIT) >= SENSOR_VOTES)) {
+		reached = true;
+		t_reached = phys;
+		res.t_run[run_no] = (long)((phys - run_start) / 1000);
+		res.runs++;
+		if (run_no == 0) {
+			res.exited = true;
+			res.t_exit = phys / 1000;
+		}
+	}
+	if (((phys % TIME_POSE) == 0) && !reached && (clock >= touch_until + TIME_POSE)) posed();
+	if ((phys % TIME_ANALOG) == 0) {
+		double l;
+		sample(l);
+		speck = (cfg.glitch > 0) && (rng.uniform() * 100 < cfg.glitch);
+		if (speck) l = maze.shade(KIND_BACKGROUND).light;
+		analog = (int)std::floor(l + cfg.ambient + rng.symmetric() * cfg.light_noise + 0.5);
+		analog = std::max(0, std::min(100, analog));
+		res.samples++;
+		res.conf += program->current_conf();
+	}
+	// lost when the axis is off the poster, unless leaving through the exit
+	double margin = maze.pitch(world) / 2;
+	if (!reached && ((x < -margin) || (y < -margin) ||
+		(x > maze.width(world) + margin) || (y > maze.height(world) + margin))) {
+		res.lost = true;
+		stop = true;
+	}
+}
+// tick
+
+/*!
+	\brief Samples the sensor spot
+
+	The spot is sampled at its center and six points on a ring.
+	The light value is the mean reflection. The HT color number is
+	the color seen by at least SENSOR_VOTES of the seven points,
+	anything else reads as a mixed pastel color.
+
+	\param	light	Set to the reflected light in percent
+	\return	The HT color number
+*/
+int Runtime::sample (double &light)
+{
+	double sx = x + model.robot.sdist * std::cos(heading);
+	double sy = y + model.robot.sdist * std::sin(heading);
+	int colors[7];
+	light = 0;
+	for (int i = 0; i < 7; i++) {
+		double px = sx, py = sy;
+		if (i > 0) {
+			px += SENSOR_SPOT * std::cos(i * M_PI / 3);
+			py += SENSOR_SPOT * std::sin(i * M_PI / 3);
+		}
+		const Shade &s = maze.shade(maze.kind(world, px, py));
+		light += s.light / 7.0;
+		colors[i] = s.color;
+	}
+	for (int i = 0; i < 7; i++) {
+		int votes = 0;
+		for (int j = 0; j < 7; j++) if (colors[j] == colors[i]) votes++;
+		if (votes >= SENSOR_VOTES) return colors[i];
+	}
+	return 14;
+}
+// sample
+
+//! \brief Number of points of the sensor spot on a kind of surface
+int Runtime::spot (int kind) const
+{
+	double sx = x + model.robot.sdist * std::cos(heading);
+	double sy = y + model.robot.sdist * std::sin(heading);
+	int n = 0;
+	for (int i = 0; i < 7; i++) {
+		double px = sx, py = sy;
+		if (i > 0) {
+			px += SENSOR_SPOT * std::cos(i * M_PI / 3);
+			py += SENSOR_SPOT * std::sin(i * M_PI / 3);
+		}
+		if (maze.kind(world, px, py) == kind) n++;
+	}
+	return n;
+}
+// spot
+
+// OUTPUTS
+
+//! \brief Runs motor m at power pwr
+void Runtime::motor_run (int m, int pwr, bool regulated)
+{
+	(void)regulated;
+	if (m != OUT_B) {
+		if (!motors[OUT_A].running && !motors[OUT_C].running) t_drive = clock;
+		else stopped();
+		drive_surface = program->current_surface();
+	}
+	motors[m].power = (pwr > 100) ? 100 : (pwr < -100) ? -100 : pwr;
+	motors[m].running = true;
+	motors[m].limit = 0;
+}
+// motor_run
+
+//! \brief Brakes motor m
+void Runtime::motor_off (int m)
+{
+	bool driving = motors[OUT_A].running || motors[OUT_C].running;
+	motors[m].power = 0;
+	motors[m].running = false;
+	motors[m].limit = 0;
+	if ((m != OUT_B) && driving && !motors[OUT_A].running && !motors[OUT_C].running) stopped();
+}
+// motor_off
+
+//! \brief Times a stop of the drive if the program sees another defined surface than when it ran the motors
+void Runtime::stopped (void)
+{
+	int s = program->current_surface();
+	if ((s == 0) || (s == drive_surface) || (t_kind < t_drive) || (t_kind == t_stopped)) return;
+	t_stopped = t_kind;
+	long long t = clock - t_kind;
+	res.stops++;
+	res.t_stops += t;
+	if (t > res.t_stop_max) res.t_stop_max = (long)t;
+}
+// stopped
+
+/*!
+	\brief Compares the pose of the program to the true pose
+
+	The program tracks the axis relative to the start junction, y
+	along the start direction and x to the right of it. The robot
+	is put down slightly off the start direction, which the
+	program cannot know, so it counts as error. After the touch
+	sensor has been released for another run, the program gets a
+	period to reset its pose.
+*/
+void Runtime::posed (void)
+{
+	double px, py, ph;
+	program->current_pose(px, py, ph);
+	double p = maze.pitch(world);
+	double dx = x - (maze.start_x() + 1) * p;
+	double dy = y - (maze.start_y() + 1) * p;
+	double a = maze.start_dir() * M_PI / 2;
+	double along = dx * std::cos(a) + dy * std::sin(a);
+	double right = dx * std::sin(a) - dy * std::cos(a);
+	double e = std::hypot(px - right, py - along);
+	res.poses++;
+	res.pose_error += e;
+	if (e > res.pose_error_max) res.pose_error_max = e;
+}
+// posed
+
+//! \brief Resets counters of motor m with the next tick
+void Runtime::motor_reset (int m, int flags)
+{
+	if (flags & RESET_ROTATION_COUNT) res.resets++;
+	motors[m].reset |= flags;
+}
+// motor_reset
+
+//! \brief Stops motor m when its tacho count reaches degrees
+void Runtime::motor_limit (int m, long degrees)
+{
+	motors[m].limit = degrees;
+}
+// motor_limit
+
+long Runtime::motor_tacho (int m) const
+{
+	return (long)motors[m].tacho;
+}
+
+long Runtime::motor_rotation (int m) const
+{
+	return (long)motors[m].rotation;
+}
+
+bool Runtime::motor_running (int m) const
+{
+	return motors[m].running;
+}
+
+int Runtime::motor_speed (int m) const
+{
+	return (int)(motors[m].speed / MOTOR_DEGPERPWR);
+}
+
+// INPUTS
+
+void Runtime::sensor_type (int port, int type)
+{
+	types[port & 0x03] = type;
+}
+
+int Runtime::sensor_type (int port) const
+{
+	return types[port & 0x03];
+}
+
+//! \brief Last sample of the light sensor
+int Runtime::light (void) const
+{
+	return analog;
+}
+// light
+
+//! \brief True while the touch sensor is pressed
+bool Runtime::touched (void) const
+{
+	return clock < touch_until;
+}
+// touched
+
+//! \brief Reads the HT color sensor, the task blocks for the transaction
+int Runtime::color (void)
+{
+	double l;
+	int c = sample(l);
+	if (speck) c = maze.shade(KIND_BACKGROUND).color;
+	block(COST_I2C);
+	return c;
+}
+// color
+
+//! \brief Finds the compiled program for a maze type
+const Model &find_model (int maze_type)
+{
+	if (maze_type == MAZE_WHITE) return model_white;
+	if (maze_type == MAZE_GRAY) return model_gray;
+	if (maze_type == MAZE_COLOR) return model_color;
+	throw std::invalid_argument("unknown maze type");
+}
+// find_model
+
+//! \brief Number of the state of a name, 0 if the program has no such state
+int find_state (const Model &model, const std::string &name)
+{
+	for (const State *s = model.states; s->name; s++)
+		if (name == s->name) return s->id;
+	return 0;
+}
+// find_state
+
+} // namespace sim
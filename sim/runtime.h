@@ -0,0 +1,258 @@
+/*! \file runtime.h
+	\brief Runtime of the simulated NXT brick
+
+	The runtime runs the tasks of a program as coroutines on a
+	single simulated VM, drives the motors, moves the robot over the
+	maze poster and samples the sensors.
+
+	Time is simulated in microseconds. Every NXC call charges the VM
+	time it takes on the brick to the calling task. Tasks share the VM
+	round robin in time slices, like on the brick, so busy loops slow
+	down other tasks. Tasks waiting for Wait or an I2C transaction
+	leave the VM to the others. The motors and the robot pose are
+	updated every millisecond, like the NXT output module does.
+
+	Stops of the drive are timed from the moment the center of the
+	sensor spot moved onto another kind of surface. Only stops after
+	which the program sees another defined surface than when it last
+	ran the motors count, i.e. stops caused by a change of the
+	surface. Running the drive on for such a change, e.g. braking
+	at the middle of a junction, counts like a stop. Each change of
+	the spot is timed once, the line follower runs the drive on at
+	every sample and may see the edge flicker long after it.
+
+	Several runs can be made on the same maze. The exit is reached
+	when most of the sensor spot is on the exit strip, which is what
+	the sensors can tell apart. When the robot has
+	reached the exit and stands still after the grace period, it is
+	put back on the start and the touch sensor is pressed for
+	TIME_TOUCH. A robot still driving TIME_PICKUP after the exit
+	ends the simulation.
+
+	The files of the brick are kept in a Flash, see flash.h. Runtimes
+	sharing one Flash see the files written by the runs before.
+
+	The program may be compiled for another maze type than the one
+	of the poster, it has to tell the type itself then.
+
+	A run is deterministic for a given maze, model and configuration.
+
+	\author agent
+	\version 20261016
+
+	Changelog:
+		- 20261016 agent
+			- initial version
+			- random errors from sim::Random
+			- time spent in and entries into each state
+			- tunable parameters
+			- several runs on the same maze
+			- flash files
+			- exit reached by the sensor spot
+			- mutexes
+			- latency of stops after a change of the surface
+			- programs of any maze type on any poster, ambient light
+			- the drive run on for a change of the surface counts as a stop
+			- visits of each state from a transition into it to the next one
+*/
+#ifndef SIM_RUNTIME_H
+#define SIM_RUNTIME_H 1
+
+#include <ucontext.h>
+#include <functional>
+#include <vector>
+#include "flash.h"
+#include "maze.h"
+#include "program.h"
+#include "random.h"
+
+namespace sim {
+
+// VM TIMING
+// microseconds charged to a task
+#define COST_OP        30       //!< one cheap VM op, e.g. an iteration of a busy loop
+#define COST_OUTPUT    60       //!< reading or writing the output module
+#define COST_ANALOG    60       //!< reading an analog sensor
+#define COST_I2C       3000     //!< one I2C transaction, the task waits meanwhile
+#define COST_FILE      2000     //!< opening or closing a file
+#define TIME_SLICE     500      //!< VM time a task runs before the next one is scheduled
+#define TIME_TICK      1000     //!< output module update period
+#define TIME_ANALOG    3000     //!< analog sensor sample period
+#define TIME_TOUCH     300000   //!< the touch sensor is pressed this long to start another run
+#define TIME_PICKUP    30000000 //!< max time from the exit until the robot stops for another run
+#define TIME_POSE      10000    //!< period of comparing the pose of the program to the true pose
+
+// MOTORS
+#define MOTOR_COUNT       3        //!< output ports A, B, C
+#define MOTOR_DEGPERPWR   9.0      //!< deg/s per unit of power
+#define MOTOR_TAURUN      0.040    //!< s, time constant when running
+#define MOTOR_TAUBRAKE    0.015    //!< s, time constant when braking
+#define SENSOR_SPOT       3.0      //!< mm, radius of the sensor spot
+#define SENSOR_VOTES      5        //!< points of the spot, out of seven, which tell the surface
+
+// STATES
+#define STATE_SLOTS       16       //!< state numbers of the program which are tracked
+
+// RUNS
+#define RUNS_MAX          8        //!< maximum number of runs on the same maze
+
+//! \brief Configuration of a simulation run
+struct Config {
+	unsigned long long seed;    //!< seed of the random errors
+	long limit;                 //!< ms of simulated time before giving up
+	long grace;                 //!< ms simulated after the exit has been reached
+	double heading_error;       //!< max initial heading error in degrees
+	double wheel_bias;          //!< max relative difference of the wheel circumferences
+	double light_noise;         //!< max light sensor noise in percent
+	double ambient;             //!< percent of ambient light added to the light sensor
+	double glitch;              //!< percent of the samples of the sensors which read the background, a speck on the poster
+	Params params;              //!< tunable variables of the program
+	int runs;                   //!< runs on the same maze, at most RUNS_MAX
+	Flash *flash;               //!< files of the brick, 0 for a brick without files
+	Config (void);
+};
+
+//! \brief Outcome of a simulation run
+struct Result {
+	bool finished;      //!< task main returned
+	bool exited;        //!< the sensor reached the exit strip in the first run
+	bool lost;          //!< the robot left the poster
+	long t_exit;        //!< ms until the exit strip was reached in the first run
+	long t_end;         //!< ms until the run ended
+	double distance;    //!< mm driven by the center of the axis
+	double rotation;    //!< degrees turned in total
+	int turns;          //!< turns on the spot
+	int resets;         //!< resets of a rotation count by the program
+	long t_state[STATE_SLOTS];    //!< ms spent in each state of the program
+	double r_state[STATE_SLOTS];  //!< degrees turned in each state of the program
+	int entered[STATE_SLOTS];     //!< transitions into each state of the program
+	int visits[STATE_SLOTS];      //!< visits of each state from a transition into it to the next one
+	long t_visits[STATE_SLOTS];   //!< ms of the visits of each state
+	Params params;                //!< tunable variables as used, PARAM_KEEP if the program has none
+	int runs;                     //!< runs which reached the exit
+	long t_run[RUNS_MAX];         //!< ms from the start of each run to the exit
+	int stops;                    //!< stops of the drive caused by a change of the surface
+	long long t_stops;            //!< us from the change of the surface to the stop, summed over all stops
+	long t_stop_max;              //!< us of the slowest stop
+	int undefined;                //!< changes of the surface observed by the program to undefined
+	int samples;                  //!< analog samples, see conf
+	long long conf;               //!< percent the program is confident of its surface, summed over all samples
+	int poses;                    //!< poses of the program compared to the true pose
+	double pose_error;            //!< mm from the pose of the program to the true pose, summed over all poses
+	double pose_error_max;        //!< mm of the worst pose
+	Result (void);
+};
+
+/*!
+	\brief Runtime of one simulated brick
+*/
+class Runtime
+{
+public:
+	Runtime (const Model &model, const Maze &maze, const Config &cfg);
+	~Runtime (void);
+	Result run (void);
+	static Runtime *current (void);
+
+	// TASKS
+	void spawn (const std::function<void(void)> &fn);
+	void cpu (long us);
+	void block (long us);
+	void acquire (Mutex &m);
+	void release (Mutex &m);
+	long long now (void) const { return clock; }
+
+	// OUTPUTS
+	void motor_run (int m, int pwr, bool regulated);
+	void motor_off (int m);
+	void motor_reset (int m, int flags);
+	void motor_limit (int m, long degrees);
+	long motor_tacho (int m) const;
+	long motor_rotation (int m) const;
+	bool motor_running (int m) const;
+	int motor_speed (int m) const;
+
+	// INPUTS
+	void sensor_type (int port, int type);
+	int sensor_type (int port) const;
+	int light (void) const;
+	bool touched (void) const;
+	int color (void);
+
+	// FILES
+	Flash &files (void) { return *flash; }    //!< files of the brick
+
+private:
+	struct Task {
+		ucontext_t ctx;                   //!< saved context
+		std::vector<char> stack;          //!< coroutine stack
+		std::function<void(void)> fn;     //!< task body
+		long long wake;                   //!< blocked until
+		bool done;                        //!< returned
+	};
+	struct Motor {
+		int power;          //!< commanded power
+		bool running;       //!< motor on
+		int reset;          //!< counters to reset on next tick
+		long limit;         //!< tacho limit, 0 for none
+		double speed;       //!< deg/s
+		double tacho;       //!< tacho count
+		double rotation;    //!< rotation count
+	};
+
+	static void trampoline (void);
+	void schedule (void);
+	void tick (void);
+	void advance (void);
+	int sample (double &light);
+	int spot (int kind) const;
+	void account (void);
+	void place (void);
+	void restart (void);
+	void stopped (void);
+	void posed (void);
+
+	const Model &model;              //!< compiled program and metrics
+	const WorldMetrics &world;       //!< metrics of the poster, of its maze type
+	const Maze &maze;                //!< the poster
+	Config cfg;                      //!< run configuration
+	Program *program;                //!< the program instance
+	std::vector<Task*> tasks;        //!< all spawned tasks
+	size_t cur;                      //!< index of the running task
+	ucontext_t host;                 //!< context of run()
+	long long clock;                 //!< simulated time in us
+	long long slice;                 //!< us the running task has used of its slice
+	long long phys;                  //!< time of the last tick
+	bool stop;                       //!< abort all tasks
+	Motor motors[MOTOR_COUNT];       //!< output ports
+	int types[4];                    //!< sensor types of the input ports
+	int analog;                      //!< last light sensor sample
+	bool speck;                      //!< the last sample read the background, see Config::glitch
+	double x, y, heading;            //!< pose of the axis center, mm and rad
+	double circl, circr;             //!< wheel circumferences
+	bool spinning;                   //!< turning on the spot
+	Random rng;                      //!< random errors
+	int state;                       //!< last seen state of the program
+	int observed;                    //!< last seen surface of the program, 0 if undefined
+	long long since;                 //!< time the state was entered
+	long long t_state[STATE_SLOTS];  //!< us spent in each state
+	bool entry;                      //!< the state was entered by a transition, not started in
+	long long t_visits[STATE_SLOTS]; //!< us of the visits of each state
+	int run_no;                      //!< the current run, from 0
+	long long run_start;             //!< time the current run started
+	bool reached;                    //!< the current run reached the exit
+	long long t_reached;             //!< time the current run reached the exit
+	long long touch_until;           //!< the touch sensor is pressed until
+	int kind;                        //!< kind of surface under the center of the sensor spot
+	long long t_kind;                //!< time the center of the spot moved onto it
+	long long t_drive;               //!< time the drive motors were started
+	long long t_stopped;             //!< t_kind of the last stop, each change of the spot is timed once
+	int drive_surface;               //!< surface of the program when the drive motors were last run
+	Flash own;                       //!< files if the configuration has none
+	Flash *flash;                    //!< the files of the brick
+	Result res;                      //!< outcome so far
+};
+
+} // namespace sim
+
+#endif // SIM_RUNTIME_H
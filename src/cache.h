@@ -0,0 +1,211 @@
+/*! \file cache.h
+	\brief Routes learned in earlier runs, kept in a flash file
+
+	When the robot has found the exit by exploring, the turns to the
+	exit (see path.h) are appended to the file CACHE_FILE. After
+	switching the brick off and on, main reads the file once
+	calibrate has told the maze type, such that the robot can replay
+	a route instead of exploring again. A route
+	is keyed by the maze type and a signature of the first turns
+	taken when exploring. The robot explores until its signature is
+	known and replays the newest route with that key.
+
+	The file is created with CACHE_SIZE bytes and only appended to.
+	Each record is
+
+		byte    CACHE_MAGIC
+		byte    maze type
+		byte    signature, low byte
+		byte    signature, high byte
+		byte    number of turns n
+		byte[]  turns, (n+3)/4 bytes, four turns per byte starting
+		        at the low bits
+		byte    sum of all bytes before, modulo 256
+
+	A record is only written after a run got to the exit, so a failed
+	run never touches the file. A record that is cut off or does not
+	add up is skipped when loading, the records before and after it
+	are still found. When the file is full, no more routes are
+	learned until it is deleted.
+
+	Provides the functions:
+		- cache_load: read the file, are there routes of a maze type
+		- cache_find: the newest route of a maze type and signature
+		- cache_save: append the route in cache_path
+		- cache_write: write a byte
+
+	\author agent
+	\version 20261016
+
+	Changelog:
+		- 20261016 agent
+			- initial version
+			- fields written through a byte, Write takes the width
+			  of its argument
+*/
+#ifndef CACHE_H
+#define CACHE_H 1
+
+#define CACHE_FILE      "routes.dat"  //!< name of the file
+#define CACHE_SIZE      1024      //!< bytes of the file
+#define CACHE_TURNS     128       //!< maximum number of turns of a route
+#define CACHE_MAGIC     0xA7      //!< first byte of each record
+#define CACHE_HEADER    5         //!< bytes of a record before the turns
+
+// GLOBALS
+#ifdef NXTSIM
+byte cache_data[CACHE_SIZE];      //!< the file (fixed size in C++)
+byte cache_path[CACHE_TURNS];     //!< turns of the route, a turn per byte
+#else
+byte cache_data[];                //!< the file
+byte cache_path[];                //!< turns of the route, a turn per byte
+#endif
+int cache_length = 0;             //!< bytes of the file
+int cache_count = 0;              //!< number of turns of the route
+unsigned int cache_sign = 0;      //!< signature of the route
+bool cache_found = false;         //!< there are routes of the maze type
+
+/*!
+	\brief Checks the record at a position of the file
+
+	\param	pos	position of the record in cache_data
+	\return	position of the checksum, -1 if there is no valid record
+*/
+int cache_record (int pos)
+{
+	if ((pos + CACHE_HEADER >= cache_length) || (cache_data[pos] != CACHE_MAGIC)) return -1;
+	int count = cache_data[pos + 4];
+	int end = pos + CACHE_HEADER + (count + 3) / 4;
+	if ((count > CACHE_TURNS) || (end >= cache_length)) return -1;
+	int sum = 0;
+	for (int i = pos; i < end; i++) sum += cache_data[i];
+	if (cache_data[end] != (sum % 256)) return -1;
+	return end;
+}
+// cache_record
+
+/*!
+	\brief Reads the file
+
+	\param	type	the maze type
+	\return	true if there are routes of the maze type
+*/
+bool cache_load (int type)
+{
+	byte handle;
+	unsigned int size;
+	ArrayInit(cache_data, 0, CACHE_SIZE);
+	ArrayInit(cache_path, 0, CACHE_TURNS);
+	cache_length = 0;
+	cache_found = false;
+	if (OpenFileRead(CACHE_FILE, size, handle) != LDR_SUCCESS) return false;
+	if (size > CACHE_SIZE) size = CACHE_SIZE;
+	int max = size;
+	byte b;
+	while ((cache_length < max) && (Read(handle, b) == LDR_SUCCESS)) {
+		cache_data[cache_length] = b;
+		cache_length++;
+	}
+	CloseFile(handle);
+	for (int pos = 0; pos < cache_length; pos++) {
+		if ((cache_record(pos) >= 0) && (cache_data[pos + 1] == type)) cache_found = true;
+	}
+	return cache_found;
+}
+// cache_load
+
+/*!
+	\brief Finds the newest route of a maze type and signature
+
+	Records which do not check out are skipped byte by byte until
+	the next one that does. The route is unpacked to cache_path.
+
+	\param	type	the maze type
+	\param	sign	the signature
+	\return	true if there is a route
+*/
+bool cache_find (int type, unsigned int sign)
+{
+	bool found = false;
+	int pos = 0;
+	while (pos < cache_length) {
+		int end = cache_record(pos);
+		if (end < 0) {
+			pos++;
+			continue;
+		}
+		unsigned int key = cache_data[pos + 2] + 256 * cache_data[pos + 3];
+		if ((cache_data[pos + 1] == type) && (key == sign)) {
+			cache_count = cache_data[pos + 4];
+			for (int i = 0; i < cache_count; i++) {
+				cache_path[i] = (cache_data[pos + CACHE_HEADER + i / 4] >> (2 * (i % 4))) & 0x03;
+			}
+			cache_sign = sign;
+			found = true;
+		}
+		pos = end + 1;
+	}
+	return found;
+}
+// cache_find
+
+/*!
+	\brief Writes one byte to the file
+
+	Write takes as many bytes as the type of its argument, so each
+	field of a record goes through a byte.
+
+	\return	true if the byte has been written
+*/
+bool cache_write (byte handle, byte value)
+{
+	return Write(handle, value) == LDR_SUCCESS;
+}
+// cache_write
+
+/*!
+	\brief Appends the route in cache_path to the file
+
+	Creates the file if there is none.
+
+	\param	type	the maze type
+	\return	true if the route has been written
+*/
+bool cache_save (int type)
+{
+	byte handle;
+	unsigned int size;
+	int n = (cache_count + 3) / 4;
+	unsigned int result = OpenFileAppend(CACHE_FILE, size, handle);
+	if (result == LDR_FILENOTFOUND) {
+		size = CACHE_SIZE;
+		result = CreateFile(CACHE_FILE, size, handle);
+	}
+	if (result != LDR_SUCCESS) return false;
+	int space = size;
+	if (space < CACHE_HEADER + n + 1) {
+		CloseFile(handle);
+		return false;
+	}
+	int sum = CACHE_MAGIC + type + cache_sign % 256 + cache_sign / 256 + cache_count;
+	bool written = cache_write(handle, CACHE_MAGIC);
+	written = cache_write(handle, type) && written;
+	written = cache_write(handle, cache_sign % 256) && written;
+	written = cache_write(handle, cache_sign / 256) && written;
+	written = cache_write(handle, cache_count) && written;
+	for (int i = 0; i < n; i++) {
+		int packed = 0;
+		for (int k = 3; k >= 0; k--) {
+			packed = packed * 4;
+			if (4 * i + k < cache_count) packed += cache_path[4 * i + k];
+		}
+		sum += packed;
+		written = cache_write(handle, packed) && written;
+	}
+	written = cache_write(handle, sum % 256) && written;
+	CloseFile(handle);
+	return written;
+}
+// cache_save
+
+#endif // CACHE_H
@@ -9,6 +9,8 @@
 	\version 20101123
 	
 	Changelog:
+		- 20261016 agent
+			- robotstatus prints the pose instead of the rotation counts
 		- 20110517 thomas.zink
 			- corrections on documentation
 			- moved all remaining debugging functions to debug.h
@@ -51,13 +53,13 @@ task robotstatus (void)
 {
 	while (true) {
 		int i;
-		printInformation(LCD_LINE1, "speed <-:", MotorActualSpeed(MOTOR_LEFT));
-		printInformation(LCD_LINE2, "speed ->:", MotorActualSpeed(MOTOR_RIGHT));
+		printInformation(LCD_LINE1, "x mm:", pose_x / POSE_SCALE);
+		printInformation(LCD_LINE2, "y mm:", pose_y / POSE_SCALE);
 		printInformation(LCD_LINE3, "light:", LIGHT_VALUE);
 		printInformation(LCD_LINE4, "color:", COLOR_VALUE);		
 		printInformation(LCD_LINE5, "surface:", surface);		
-		printInformation(LCD_LINE6, "rot. <-:", abs(MotorRotationCount(MOTOR_LEFT)));
-		printInformation(LCD_LINE7, "rot. ->:", abs(MotorRotationCount(MOTOR_RIGHT)));
+		printInformation(LCD_LINE6, "heading:", pose_degrees());
+		printInformation(LCD_LINE7, "speed:", (MotorActualSpeed(MOTOR_LEFT) + MotorActualSpeed(MOTOR_RIGHT)) / 2);
 		printInformation(LCD_LINE8, "state :", abs(state));			
 		Wait(100);       
 	}
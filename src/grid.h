@@ -0,0 +1,142 @@
+/*! \file grid.h
+	\brief Bit-packed grid of the maze junctions
+
+	Keeps what is known about each junction of a maze of up to
+	GRID_COLS x GRID_ROWS junctions in four bits:
+
+		- GRID_EAST: there is a line to the junction east of it
+		- GRID_NORTH: there is a line to the junction north of it
+		- GRID_VISITED: the robot has been there
+		- GRID_EXIT: the exit strip leaves the junction
+
+	Lines to the west and south are the east and north lines of the
+	neighbours, such that each line is stored once. Two junctions
+	share a byte, junction (x,y) is at index y*GRID_COLS+x, the even
+	index in the low bits. A 32x32 grid takes 512 bytes. Lookup and
+	update are O(1).
+
+	Directions are quarter turns counter clockwise from north, like
+	the headings of map.h with north the start heading.
+
+	The same code runs on the host, see sim/packed.h.
+
+	Provides the functions:
+		- grid_init: forget all junctions
+		- grid_contains: is a junction on the grid
+		- grid_get: the bits of a junction
+		- grid_set: set bits of a junction
+		- grid_clear: clear bits of a junction
+		- grid_line: is there a line from a junction in a direction
+		- grid_link: add a line from a junction in a direction
+
+	\author agent
+	\version 20261016
+
+	Changelog:
+		- 20261016 agent
+			- initial version
+*/
+#ifndef GRID_H
+#define GRID_H 1
+
+#define GRID_COLS       32        //!< junctions per row
+#define GRID_ROWS       32        //!< rows of junctions
+#define GRID_BYTES      (GRID_COLS * GRID_ROWS / 2)    //!< bytes of the grid
+
+// BITS
+// of a junction
+#define GRID_EAST       0x01      //!< line to the east
+#define GRID_NORTH      0x02      //!< line to the north
+#define GRID_VISITED    0x04      //!< visited
+#define GRID_EXIT       0x08      //!< the exit strip leaves the junction
+
+// DIRECTIONS
+// quarter turns counter clockwise from north
+#define GRID_DIR_NORTH  0x00      //!< towards larger y
+#define GRID_DIR_WEST   0x01      //!< towards smaller x
+#define GRID_DIR_SOUTH  0x02      //!< towards smaller y
+#define GRID_DIR_EAST   0x03      //!< towards larger x
+
+// GLOBALS
+#ifdef NXTSIM
+byte grid[GRID_BYTES];            //!< two junctions per byte (fixed size in C++)
+#else
+byte grid[];                      //!< two junctions per byte
+#endif
+
+//! \brief Forgets all junctions
+void grid_init (void)
+{
+	ArrayInit(grid, 0, GRID_BYTES);
+}
+// grid_init
+
+//! \brief True if (x,y) is on the grid
+bool grid_contains (int x, int y)
+{
+	return (x >= 0) && (x < GRID_COLS) && (y >= 0) && (y < GRID_ROWS);
+}
+// grid_contains
+
+//! \brief The bits of junction (x,y), which must be on the grid
+int grid_get (int x, int y)
+{
+	int i = y * GRID_COLS + x;
+	return (grid[i >> 1] >> ((i & 1) << 2)) & 0x0F;
+}
+// grid_get
+
+//! \brief Sets bits of junction (x,y), which must be on the grid
+void grid_set (int x, int y, int bits)
+{
+	int i = y * GRID_COLS + x;
+	grid[i >> 1] = grid[i >> 1] | ((bits & 0x0F) << ((i & 1) << 2));
+}
+// grid_set
+
+//! \brief Clears bits of junction (x,y), which must be on the grid
+void grid_clear (int x, int y, int bits)
+{
+	int i = y * GRID_COLS + x;
+	grid[i >> 1] = grid[i >> 1] & (0xFF ^ ((bits & 0x0F) << ((i & 1) << 2)));
+}
+// grid_clear
+
+/*!
+	\brief True if there is a line from junction (x,y) in a direction
+
+	Lines off the grid are never there.
+*/
+bool grid_line (int x, int y, int dir)
+{
+	if (dir == GRID_DIR_NORTH) return grid_contains(x, y + 1) && (grid_get(x, y) & GRID_NORTH);
+	if (dir == GRID_DIR_EAST) return grid_contains(x + 1, y) && (grid_get(x, y) & GRID_EAST);
+	if (dir == GRID_DIR_SOUTH) return grid_contains(x, y - 1) && (grid_get(x, y - 1) & GRID_NORTH);
+	return grid_contains(x - 1, y) && (grid_get(x - 1, y) & GRID_EAST);
+}
+// grid_line
+
+/*!
+	\brief Adds a line from junction (x,y) in a direction
+
+	\return	false if the line leaves the grid
+*/
+bool grid_link (int x, int y, int dir)
+{
+	if (dir == GRID_DIR_SOUTH) {
+		y--;
+		dir = GRID_DIR_NORTH;
+	}
+	else if (dir == GRID_DIR_WEST) {
+		x--;
+		dir = GRID_DIR_EAST;
+	}
+	if (!grid_contains(x, y)) return false;
+	if ((dir == GRID_DIR_NORTH) && grid_contains(x, y + 1)) grid_set(x, y, GRID_NORTH);
+	else if ((dir == GRID_DIR_EAST) && grid_contains(x + 1, y)) grid_set(x, y, GRID_EAST);
+	else return false;
+	return true;
+}
+// grid_link
+
+#endif // GRID_H
@@ -9,12 +9,40 @@
 	There are wrappers available in libNXC.h that wrap
 	these functions and make them available in NXC.
 
+	Routines passed compile-time constants fold their arithmetic
+	with compif/isconst like __ArrBuildPort. Degrees2Rotations,
+	Rotations2Degrees and RotateMotorMm compute in the return variable
+	of the caller and are reentrant. RotateBaseDegrees keeps its
+	arguments in the data segment of an instance. Tasks turning at
+	once declare an instance each, see __RotateBaseDegreesInstance.
+	RotateBaseDegrees turns with a shared instance guarded by a
+	mutex. Defining LIBNBC_SHARED 0 before the include leaves out
+	the shared instance, its mutex and RotateBaseDegrees, when every
+	task that turns has an instance of its own.
+
 	\author thomas.zink
-	\version 20101123
+	\version 20261016
+
+	Changelog:
+		- 20261016 agent
+			- constant arguments folded at compile time
+			- LIBNBC_SHARED
+			- Degrees2Rotations, Rotations2Degrees and RotateMotorMm
+			  without data segment and mutex
+			- instances of RotateBaseDegrees per task
+			- RotateBaseDegrees relative to the rotation counts without
+			  resetting them, returns the degrees turned
+			- ArrayBuildPort of a variable looks up __ArrPortTable
+			- RotateBaseDegrees copies the ports from __ArrPortTable only
+			  when they change
 */
 #ifndef LIBNBC__H
 #define LIBNBC__H 1
 
+#ifndef LIBNBC_SHARED
+#define LIBNBC_SHARED 1     //!< RotateBaseDegrees turns with a shared instance, 0 leaves it out
+#endif
+
 /*
 	\name Degrees2Rotations
 	Takes a number of degrees and calculates the number of rotations
@@ -28,27 +56,14 @@
 	\return		Number of rotations
 */
 
-// DATA
-dseg segment
-	__deg2rot_mutex       mutex   //!< mutex to ensure mutual exclusion
-	__deg2rot_rotations   slong   //!< rotations
-	__deg2rot_degrees     slong   //!< degrees
-dseg ends
-
-// SUBROUTINE
-subroutine __deg2rot_sub
-	set    __deg2rot_rotations,   360                                       // rotations = 360
-	div    __deg2rot_rotations,   __deg2rot_degrees,    __deg2rot_rotations // rotations = degrees / rotations
-	return
-ends
-
 // MACRO
+// computed in the return variable of the caller, no shared data
 #define __Degrees2Rotations(_deg,_R) \
-	acquire  __deg2rot_mutex \
-	mov      __deg2rot_degrees, _deg \
-	call     __deg2rot_sub \
-	mov      _R,                __deg2rot_rotations \
-	release  __deg2rot_mutex
+	compif   EQ,                isconst(_deg),        TRUE \
+	mov      _R,                ((_deg)/360) \
+	compelse \
+	div      _R,                _deg,                 360 \
+	compend
 
 // WRAPPER
 #ifndef Degrees2Rotations
@@ -68,23 +83,14 @@ ends
 	\return Number of degrees the motor turned
 */
 
-// DATA
-// we don't need a data segment. We will use the same data as Degrees2Rotations
-
-// SUBROUTINE
-subroutine __rot2deg_sub
-	set    __deg2rot_degrees,   360                                     // degrees = 360
-	mul    __deg2rot_degrees,    __deg2rot_degrees,	__deg2rot_rotations // degrees = degrees * rotations
-	return
-ends
-
 // MACRO
+// computed in the return variable of the caller, no shared data
 #define __Rotations2Degrees(_rot,_R) \
-	acquire  __deg2rot_mutex \
-	mov      __deg2rot_rotations,  _rot \
-	call     __rot2deg_sub \
-	mov      _R,                   __deg2rot_degrees \
-	release  __deg2rot_mutex
+	compif   EQ,                   isconst(_rot),        TRUE \
+	mov      _R,                   ((_rot)*360) \
+	compelse \
+	mul      _R,                   _rot,                 360 \
+	compend
 
 // WRAPPER
 #ifndef Rotations2Degrees
@@ -103,13 +109,26 @@ ends
 	a variable does not work. The array must be manually built.
 	This macro builds an array according to the output port
 	constant.
+
+	Constant ports are built by arrbuild at compile time. Ports in
+	a variable index __ArrPortTable, which holds the arrays of
+	OUT_A to OUT_ABC once for all routines. RotateBaseDegrees
+	indexes the table itself, see there. The variable must hold
+	one of the port constants.
 	
 	\param		arr			The array which will be build
 	\param		outs		The output constant
 */
+// DATA
+dseg segment
+	// the arrays of the output port constants, indexed by the constant
+	__ArrPortTable		ubyte[][]		{{OUT_A}, {OUT_B}, {OUT_C}, {OUT_A, OUT_B}, {OUT_A, OUT_C}, {OUT_B, OUT_C}, {OUT_A, OUT_B, OUT_C}}
+dseg ends
+
+// MACRO
 #define __ArrBuildPort(_arr, _ports) \
 	compif		EQ,		isconst(_ports), 	FALSE		\
-	arrbuild	_arr,	_ports										\
+	index			_arr,	__ArrPortTable,		_ports		\
 	compelse																	\
 	compchk		GT,		_ports,				0x02				\
 	compchk		LT,		_ports,				0x07				\
@@ -149,35 +168,29 @@ ends
 	\param	_circ			Circumference of the wheel(s) in mm.
 	\param 	_R				Desired return variable
 	\return Number of degrees the wheel(s) have been turned.
+
+	The degrees are computed in the return variable of the caller,
+	there is no shared data segment, so tasks may call it at once on
+	different ports. With constant mm and circumference the degrees
+	are folded at compile time.
 */
-// DATA
-dseg segment
-	__rotateMMm_mutex		mutex		//!< mutex
-	__rotateMMm_result	ulong		//!< return value degrees (_R)
-	__rotateMMm_mm			sword		//!< parameter distance in mm (_mm)
-	__rotateMMm_circ		uword		//!< circumference in mm (_circ)
-	/* we don't need a variable for _ports and _pwr since we will pass them
-		directly to RotateMotor()	*/
-dseg ends
+// MACRO
+#define __RotateMotorMmVar(_ports, _pwr, _mm, _circ, _R)					\
+	mul					_R,									_mm,						360					\
+	div					_R,									_R,							_circ				\
+	RotateMotor(_ports, _pwr, _R);
 
-// SUBROUTINE
-subroutine __rotateMMm_sub
-	// compute degrees = ((mm*360) / circ);
-	set 	__rotateMMm_result, 	360																				// result = 360
-	mul		__rotateMMm_result, 	__rotateMMm_result, 	__rotateMMm_mm			// result = result * mm
-	div 	__rotateMMm_result, 	__rotateMMm_result, 	__rotateMMm_circ		// result = result / circumference
-	return
-ends
+// degrees folded at compile time
+#define __RotateMotorMmConst(_ports, _pwr, _mm, _circ, _R)				\
+	RotateMotor(_ports, _pwr, (((_mm)*360)/(_circ))); \
+	mov					_R,									(((_mm)*360)/(_circ))
 
-// MACRO
 #define __RotateMotorMm(_ports, _pwr, _mm, _circ, _R)							\
-	acquire			__rotateMMm_mutex 																	\
-	mov					__rotateMMm_mm, 		_mm															\
-	mov					__rotateMMm_circ, 	_circ														\
-	call __rotateMMm_sub \
-	RotateMotor(_ports, _pwr, __rotateMMm_result); \
-	mov					_R,									__rotateMMm_result							\
-	release			__rotateMMm_mutex
+	compif			EQ,		isconst(_mm)+isconst(_circ),		2						\
+	__RotateMotorMmConst(_ports, _pwr, _mm, _circ, _R)								\
+	compelse																							\
+	__RotateMotorMmVar(_ports, _pwr, _mm, _circ, _R)									\
+	compend
 	
 // WRAPPER
 #ifndef RotateMotorMm
@@ -195,7 +208,7 @@ ends
 	pass a valid output specifier. A corresonding NXC function has the
 	following declaration:
 	
-	unsigned long RotateBaseDegrees (byte outputs, char pwr, int degrees, unsigned int diam, unsigned int ccdist);
+	long RotateBaseDegrees (byte outputs, char pwr, int degrees, unsigned int diam, unsigned int ccdist);
 	
 	\param	_ports			Desired output ports. Can be a constant or a variable.
 											Either way an output array will automatically be built
@@ -203,86 +216,146 @@ ends
 	\param	_degrees		Number of degrees to turn. Can be negative to reverse direction
 	\param	_diam				Diameter of the wheels
 	\param	_ccdist			Center-to-center distance between the wheels
-	\return Number of rotations performed by the wheels
+	\return Number of degrees the base turned, measured by the wheels
+
+	The wheels turn relative to their rotation counts at the start,
+	which are not reset, such that the turn starts at once and
+	odometry from the counts goes on. The degrees turned come from
+	the counts after the brake, the caller may correct the rest.
+
+	The arguments and the rotation counts are kept in the data segment
+	of an instance. __RotateBaseDegreesInstance(_id) declares the data
+	and subroutines of instance _id, __RotateBaseDegreesOn(_id,...)
+	turns with it. Each task turning on its own instance needs no
+	mutex and never waits for another one. RotateBaseDegrees uses the
+	instance shared, guarded by a mutex, which exists only if
+	LIBNBC_SHARED.
+
+	With constant degrees, diameter and distance the turn percentage
+	and the rotations are folded at compile time, only the port
+	and run subroutines of the instance are called.
+
+	An instance keeps the ports array of its last turn. The row of
+	__ArrPortTable is copied only when the ports change, a task
+	turning on the same wheels copies it once.
 */
+// INSTANCE
+// data and subroutines, the same as __rotbase_sub and __rotbase_run
+// of the single instance before:
+//	- port: the ports array and port0, port1 of the ports wanted, taken
+//	  from __ArrPortTable only when they differ from the last call
+//	- sub: turnpct = sign(degrees) * 100, target = abs(degrees) * ccdist / diam
+//	- run: keep the rotation counts of port0 and port1 in from0 and from1,
+//	  start the motors synchronized, wait until both have turned target
+//	  degrees since, off, result = degrees of the base turned
+#define __RotateBaseDegreesInstance(_id)																\
+dseg segment																														\
+	__rotbase_##_id##_ports			ubyte[]																			\
+	__rotbase_##_id##_outs			ubyte		0xFF																\
+	__rotbase_##_id##_want			ubyte																				\
+	__rotbase_##_id##_port0			ubyte																				\
+	__rotbase_##_id##_port1			ubyte																				\
+	__rotbase_##_id##_pwr				ubyte																				\
+	__rotbase_##_id##_degrees		sword																				\
+	__rotbase_##_id##_diam			uword																				\
+	__rotbase_##_id##_ccdist		uword																				\
+	__rotbase_##_id##_turnpct		sbyte																				\
+	__rotbase_##_id##_target		ulong																				\
+	__rotbase_##_id##_result		slong																				\
+	__rotbase_##_id##_abs				uword																				\
+	__rotbase_##_id##_from0			slong																				\
+	__rotbase_##_id##_from1			slong																				\
+	__rotbase_##_id##_rot0			slong																				\
+	__rotbase_##_id##_rot1			slong																				\
+dseg ends																																\
+subroutine __rotbase_##_id##_port																				\
+	brcmp		EQ,	__rotbase_##_id##_kept,	__rotbase_##_id##_outs,	__rotbase_##_id##_want	\
+	mov			__rotbase_##_id##_outs,		__rotbase_##_id##_want										\
+	index		__rotbase_##_id##_ports,	__ArrPortTable,		__rotbase_##_id##_outs	\
+	index		__rotbase_##_id##_port0,	__rotbase_##_id##_ports,	0								\
+	index		__rotbase_##_id##_port1,	__rotbase_##_id##_ports,	1								\
+__rotbase_##_id##_kept:																									\
+	return																																\
+ends																																		\
+subroutine __rotbase_##_id##_sub																				\
+	sign	__rotbase_##_id##_turnpct,	__rotbase_##_id##_degrees							\
+	mul		__rotbase_##_id##_turnpct,	__rotbase_##_id##_turnpct,	100				\
+	abs		__rotbase_##_id##_abs,			__rotbase_##_id##_degrees							\
+	mul		__rotbase_##_id##_target,		__rotbase_##_id##_abs,	__rotbase_##_id##_ccdist	\
+	div		__rotbase_##_id##_target,		__rotbase_##_id##_target,	__rotbase_##_id##_diam	\
+	return																																\
+ends																																		\
+subroutine __rotbase_##_id##_run																				\
+	getout 	__rotbase_##_id##_from0,	__rotbase_##_id##_port0,	RotationCount	\
+	getout 	__rotbase_##_id##_from1,	__rotbase_##_id##_port1,	RotationCount	\
+	OnFwdSync(__rotbase_##_id##_ports, __rotbase_##_id##_pwr, __rotbase_##_id##_turnpct)	\
+__rotbase_##_id##_while:																								\
+	getout 	__rotbase_##_id##_rot0,		__rotbase_##_id##_port0,	RotationCount	\
+	sub			__rotbase_##_id##_rot0,		__rotbase_##_id##_rot0,		__rotbase_##_id##_from0	\
+	abs			__rotbase_##_id##_rot0,		__rotbase_##_id##_rot0										\
+	getout 	__rotbase_##_id##_rot1,		__rotbase_##_id##_port1,	RotationCount	\
+	sub			__rotbase_##_id##_rot1,		__rotbase_##_id##_rot1,		__rotbase_##_id##_from1	\
+	abs			__rotbase_##_id##_rot1,		__rotbase_##_id##_rot1										\
+	brcmp		<,	__rotbase_##_id##_while,	__rotbase_##_id##_rot0,	__rotbase_##_id##_target	\
+	brcmp		<,	__rotbase_##_id##_while,	__rotbase_##_id##_rot1,	__rotbase_##_id##_target	\
+	Off(__rotbase_##_id##_ports)																					\
+	getout 	__rotbase_##_id##_rot0,		__rotbase_##_id##_port0,	RotationCount	\
+	sub			__rotbase_##_id##_rot0,		__rotbase_##_id##_rot0,		__rotbase_##_id##_from0	\
+	abs			__rotbase_##_id##_rot0,		__rotbase_##_id##_rot0										\
+	getout 	__rotbase_##_id##_rot1,		__rotbase_##_id##_port1,	RotationCount	\
+	sub			__rotbase_##_id##_rot1,		__rotbase_##_id##_rot1,		__rotbase_##_id##_from1	\
+	abs			__rotbase_##_id##_rot1,		__rotbase_##_id##_rot1										\
+	add			__rotbase_##_id##_result,	__rotbase_##_id##_rot0,		__rotbase_##_id##_rot1	\
+	mul			__rotbase_##_id##_result,	__rotbase_##_id##_result,	__rotbase_##_id##_diam	\
+	mul			__rotbase_##_id##_result,	__rotbase_##_id##_result,	__rotbase_##_id##_turnpct	\
+	div			__rotbase_##_id##_result,	__rotbase_##_id##_result,	__rotbase_##_id##_ccdist	\
+	div			__rotbase_##_id##_result,	__rotbase_##_id##_result,	200						\
+	return																																\
+ends
+
+// MACRO
+#define __RotateBaseDegreesVar(_id,_ports,_pwr,_degrees,_diam,_ccdist,_R) 	\
+	mov			__rotbase_##_id##_degrees,	_degrees				\
+	mov			__rotbase_##_id##_diam,			_diam						\
+	mov			__rotbase_##_id##_ccdist,		_ccdist					\
+	call		__rotbase_##_id##_sub
+
+// turn percentage and rotations folded at compile time
+#define __RotateBaseDegreesConst(_id,_ports,_pwr,_degrees,_diam,_ccdist,_R) \
+	compif	LT,		_degrees,		0											\
+	set			__rotbase_##_id##_turnpct,	-100						\
+	mov			__rotbase_##_id##_target,		(((-(_degrees))*(_ccdist))/(_diam))	\
+	compelse																		\
+	set			__rotbase_##_id##_turnpct,	100							\
+	mov			__rotbase_##_id##_target,		(((_degrees)*(_ccdist))/(_diam))	\
+	compend																			\
+	set			__rotbase_##_id##_diam,			_diam						\
+	set			__rotbase_##_id##_ccdist,		_ccdist
+
+// turns with instance _id, no mutex
+#define __RotateBaseDegreesOn(_id,_ports,_pwr,_degrees,_diam,_ccdist,_R) 	\
+	mov			__rotbase_##_id##_pwr,			_pwr					\
+	compif	EQ,		isconst(_degrees)+isconst(_diam)+isconst(_ccdist),	3	\
+	__RotateBaseDegreesConst(_id,_ports,_pwr,_degrees,_diam,_ccdist,_R)	\
+	compelse																		\
+	__RotateBaseDegreesVar(_id,_ports,_pwr,_degrees,_diam,_ccdist,_R)		\
+	compend																			\
+	mov			__rotbase_##_id##_want,			_ports				\
+	call		__rotbase_##_id##_port										\
+	call		__rotbase_##_id##_run											\
+	mov			_R,									__rotbase_##_id##_result
+
+#if LIBNBC_SHARED
 // DATA
+// the shared instance of RotateBaseDegrees
+__RotateBaseDegreesInstance(shared)
 dseg segment
 	__rotbase_mutex			mutex
-	// output ports
-	__rotbase_ports			ubyte[]
-	__rotbase_port0			ubyte
-	__rotbase_port1			ubyte
-	// parameters
-	__rotbase_pwr				ubyte
-	__rotbase_degrees		sword
-	__rotbase_diam			uword
-	__rotbase_ccdist		uword
-	__rotbase_result		ulong
 dseg ends
 
-// SUBROUTINE
-subroutine __rotbase_sub
-	// local data segment
-	dseg segment
-		degrees		uword
-		turnpct		sbyte
-		rot0			sword
-		rot1			sword
-	dseg ends
-	// turnpct = sign(__rotbase_degrees) * 100
-	sign	turnpct,	__rotbase_degrees																	// turnpct = sign(__rotbase_degrees)
-	mul		turnpct,	turnpct,	100																			// turnpct = turnpct * 100
-	// degrees = abs(__rotbase_degrees)
-	// result = (degrees * __rotbase_ccdist) / __rotbase_diam
-	abs		degrees,	__rotbase_degrees																	// degrees = abs(__rotbase_degrees)
-	mul		__rotbase_result,		degrees,	__rotbase_ccdist							// result = degrees * __rotbase_ccdist
-	div		__rotbase_result,		__rotbase_result,		__rotbase_diam			// result = result / __rotbase_diam
-	// we could do instead
-	// RotateMotorEx(__rotbase_ports, __rotbase_pwr, __rotbase_result, turnpct, TRUE, TRUE);
-	// wait_loop {
-	wait_loop: // {
-		// reset rotation counters for __rotbase_port{0,1}
-		setout 	__rotbase_port0,	UpdateFlags,			RESET_ROTATION_COUNT	// ResetRotationCount(__rotbase_port0)
-		setout 	__rotbase_port1,	UpdateFlags,			RESET_ROTATION_COUNT	// ResetRotationCount(__rotbase_port1)
-		// get the motor rotation counters for __rotbase_port{0,1} and store them in rot{0,1}
-		getout 	rot0, 						__rotbase_port0,	RotationCount					// rot0 = MotorRotationCount(__rotbase_port0)
-		getout 	rot1, 						__rotbase_port1,	RotationCount					// rot1 = MotorRotationCount(__rotbase_port1)
-		// if rot0 != 0 || rot1 != 0 goto wait_loop
-		brtst		NEQ,							wait_loop,				rot0									// if rot0 != 0 goto wait_loop
-		brtst		NEQ,							wait_loop,				rot1									// if rot1 != 0 goto wait_loop
-	//}
-	// start motors synchronized
-	OnFwdSync(__rotbase_ports, __rotbase_pwr, turnpct);
-	// setout __rotbase_ports, Power, __rotbase_pwr, OutputMode, OUT_MODE_MOTORON+OUT_MODE_REGULATED+OUT_MODE_BRAKE, RegMode, OUT_REGMODE_SYNC, TurnRatio, __rotbase_turnpct, RunState, OUT_RUNSTATE_RUNNING, TachoLimit, 0, UpdateFlags, UF_UPDATE_TACHO_LIMIT+UF_UPDATE_MODE+UF_UPDATE_SPEED+RESET_ALL
-	// while_loop {
-	while_loop: // {
-		// get the abs of motor rotation counters ports{0,1} and stor in rot{0,1}
-		getout 	rot0, 					__rotbase_port0,	RotationCount					// rot0 = abs(MotorRotationCount(__rotbase_port0))
-		abs			rot0,						rot0
-		getout 	rot1, 					__rotbase_port1,	RotationCount					// rot1 = abs(MotorRotationCount(__rotbase_port1))
-		abs			rot1,						rot1
-		// if rot0 < result || rot 1 < result goto while_loop
-		brcmp		<, while_loop,	rot0,		__rotbase_result			// if rot0 < result || rot 1 < result goto while_loop
-		brcmp		<, while_loop,	rot1,		__rotbase_result
-	//}
-	// shut off the motors
-	Off(__rotbase_ports)
-	// return
-	return
-ends
-
-// MACRO
 #define __RotateBaseDegrees(_ports,_pwr,_degrees,_diam,_ccdist,_R) 	\
-	acquire	__rotbase_mutex														\
-	mov			__rotbase_pwr,			_pwr									\
-	mov			__rotbase_degrees,	_degrees							\
-	mov			__rotbase_diam,			_diam									\
-	mov			__rotbase_ccdist,		_ccdist								\
-	__ArrBuildPort(__rotbase_ports, _ports);					\
-	index		__rotbase_port0,		__rotbase_ports,		0	\
-	index		__rotbase_port1,		__rotbase_ports,		1	\
-	call		__rotbase_sub															\
-	mov			_R,									__rotbase_result			\
+	acquire	__rotbase_mutex											\
+	__RotateBaseDegreesOn(shared,_ports,_pwr,_degrees,_diam,_ccdist,_R)	\
 	release	__rotbase_mutex
 
 // WRAPPER
@@ -290,5 +363,6 @@ ends
 #define RotateBaseDegrees(_ports,_pwr,_degrees,_diam,_ccdist,_R) \
 	__RotateBaseDegrees(_ports,_pwr,_degrees,_diam,_ccdist,_R)
 #endif
+#endif // LIBNBC_SHARED
 
 #endif // LIBNBC__H
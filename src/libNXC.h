@@ -5,10 +5,21 @@
 	wrapper macros for the routines / macros
 	provided by libNBC.h
 	
+	The functions are reentrant, tasks may move different motors at
+	once. RotateBaseDegrees keeps its arguments in an instance,
+	tasks turning at the same time declare one each with
+	RotateBaseDegreesInstance and turn with RotateBaseDegreesOn.
+
 	\author thomas.zink
-	\version 20101123
+	\version 20261016
 	
 	Changelog:
+		- 20261016 agent
+			- reentrant functions, instances of RotateBaseDegrees
+			- RotateBaseDegrees relative to the rotation counts, returns
+			  the degrees turned
+			- ArrayBuildPort from the table ArrayPorts, indexed by the
+			  routines without a copy
 		- 20110517 thomas.zink
 			- work on comments
 		- 20101123 thomas.zink
@@ -36,17 +47,17 @@
 	a variable does not work. The array must be manually built.
 	This macro builds an array according to the output port
 	constant.
+
+	The arrays of OUT_A to OUT_ABC are kept once in ArrayPorts,
+	the macro copies the one indexed by the constant instead of
+	branching on it. The routines below index ArrayPorts where they
+	pass the ports and copy nothing.
 	
 	\param		arr			The array which will be build
 	\param		outs		The output constant
 */
-#define ArrayBuildPort(arr, outs) { \
-	if (outs <= OUT_C) { ArrayBuild(arr,outs); } \
-	else if (outs == OUT_AB) { ArrayBuild(arr,OUT_A,OUT_B); } \
-	else if (outs == OUT_AC) { ArrayBuild(arr,OUT_A,OUT_C); } \
-	else if (outs == OUT_BC) { ArrayBuild(arr,OUT_B,OUT_C); } \
-	else if (outs == OUT_ABC) { ArrayBuild(arr,OUT_A,OUT_B,OUT_C); } \
-}
+byte ArrayPorts[][] = {{OUT_A}, {OUT_B}, {OUT_C}, {OUT_A, OUT_B}, {OUT_A, OUT_C}, {OUT_B, OUT_C}, {OUT_A, OUT_B, OUT_C}};	//!< the arrays of the output port constants
+#define ArrayBuildPort(arr, outs) { arr = ArrayPorts[outs]; }
 
 /*!
 	\brief Rotate motor(s) such that wheel turn a number of mm.
@@ -56,18 +67,18 @@
 	milli meters.
 	
 	\param	outputs		Desired output ports. Can be a constant or a variable.
-										Either way an output array will automatically be built.
+										Either way the output array is taken from ArrayPorts.
 	\param 	pwr				Output power, 0 to 100. Can be negative to reverse direction.
 	\param	mm				Number of milli meters to turn the wheel(s).
 	\param	circ			Circumference of the wheel(s) in mm.
 	\return Number of degrees the wheel(s) have been turned.
+
+	Inline, such that each call has its own locals.
 */
-unsigned long RotateMotorMm (byte outputs, char pwr, int mm, unsigned int circ)
+inline unsigned long RotateMotorMm (byte outputs, char pwr, int mm, unsigned int circ)
 {
-	byte ports[];
-	ArrayBuildPort(ports, outputs);
 	unsigned long degrees = ((mm*360) / circ);
-	RotateMotor(ports, pwr, degrees);
+	RotateMotor(ArrayPorts[outputs], pwr, degrees);
 	return(degrees);
 }
 // RotateMotorMm
@@ -82,34 +93,36 @@ unsigned long RotateMotorMm (byte outputs, char pwr, int mm, unsigned int circ)
 	pass a valid output specifier.
 	
 	\param	outputs		Desired output ports. Can be a constant or a variable.
-										Either way an output array will automatically be built
+										Either way the output array is taken from ArrayPorts.
 	\param	pwr				Output power, 0 to 100. Can be negative to reverse direction.
 	\param	degrees		Number of degrees to turn. Can be negative to reverse direction
 	\param	diam			Diameter of the wheels
 	\param	ccdist		Center-to-center distance between the wheels
-	\return Number of rotations performed by the wheels
+	\return Number of degrees the base turned, measured by the wheels
+
+	The wheels turn relative to their rotation counts at the start,
+	which are not reset. Inline, such that each call has its own locals.
 */
-unsigned long RotateBaseDegrees (byte outputs, char pwr, int degrees, unsigned int diam, unsigned int ccdist) 
+inline long RotateBaseDegrees (byte outputs, char pwr, int degrees, unsigned int diam, unsigned int ccdist) 
 {
-	// don't care for that
-	byte ports[];
-	ArrayBuildPort(ports, outputs);
-	byte port0 = ports[0];
-	byte port1 = ports[1];
+	byte port0 = ArrayPorts[outputs][0];
+	byte port1 = ArrayPorts[outputs][1];
 	int turnpct = (degrees >= 0) ? 100 : -100;
-	unsigned long rotations = (abs(degrees) * ccdist) / diam;
-	// following same as (not working due to counter reset issues):
-	//RotateMotorEx(ports, pwr, rotations, turnpct, TRUE, TRUE);
-	// while the Motor Rotation Counts != 0 {
-	while((MotorRotationCount(port0) != 0) || (MotorRotationCount(port1) != 0)) {
-		ResetRotationCount(port0);
-		ResetRotationCount(port1);
-	};
-	OnFwdSync(ports,pwr,turnpct);
-	while ((abs(MotorRotationCount(port0)) <= rotations) || (abs(MotorRotationCount(port1)) <= rotations));
-	Off(ports);
-	return (rotations);
+	long target = (abs(degrees) * ccdist) / diam;
+	long from0 = MotorRotationCount(port0);
+	long from1 = MotorRotationCount(port1);
+	OnFwdSync(ArrayPorts[outputs],pwr,turnpct);
+	while ((abs(MotorRotationCount(port0) - from0) < target) || (abs(MotorRotationCount(port1) - from1) < target));
+	Off(ArrayPorts[outputs]);
+	long turned = abs(MotorRotationCount(port0) - from0) + abs(MotorRotationCount(port1) - from1);
+	return ((turned * diam * turnpct) / (ccdist * 200));
 }
+// RotateBaseDegrees
+
+// each call of the inline RotateBaseDegrees is an instance of its own
+#define RotateBaseDegreesInstance(_id)
+#define RotateBaseDegreesOn(_id,_ports,_pwr,_degrees,_diam,_ccdist) \
+	RotateBaseDegrees(_ports,_pwr,_degrees,_diam,_ccdist)
 
 #endif // USENBC == 0
 #if USENBC == 1
@@ -141,10 +154,25 @@ asm { 														\
 	__RotateMotorMm(_ports, _pwr, _mm, _circ, __RETVAL__)	\
 }
 
+// only with the shared instance, see LIBNBC_SHARED in libNBC.h
+#if !defined(LIBNBC_SHARED) || LIBNBC_SHARED
 #define RotateBaseDegrees(_ports,_pwr,_degrees,_diam,_ccdist) 				\
 asm {																		\
 	__RotateBaseDegrees(_ports,_pwr,_degrees,_diam,_ccdist,__RETVAL__)	\
 }
+#endif
+
+// declares instance _id of RotateBaseDegrees, at global scope
+#define RotateBaseDegreesInstance(_id) 				\
+asm {																		\
+	__RotateBaseDegreesInstance(_id)	\
+}
+
+// turns with instance _id, which no other task may use at the same time
+#define RotateBaseDegreesOn(_id,_ports,_pwr,_degrees,_diam,_ccdist) 				\
+asm {																		\
+	__RotateBaseDegreesOn(_id,_ports,_pwr,_degrees,_diam,_ccdist,__RETVAL__)	\
+}
 
 
 asm {
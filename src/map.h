@@ -0,0 +1,312 @@
+/*! \file map.h
+	\brief Map of the junctions seen while exploring the maze
+
+	While the robot explores the maze it builds a graph of the
+	junctions it passes. Junctions are identified by their grid
+	position relative to the start junction. The position is dead
+	reckoned from the heading and the length of each segment:
+
+		- the heading is counted in quarter turns counter clockwise,
+		  0 is the heading at the start. It is updated from the
+		  rotation counts of the turns at a junction, rounded to
+		  quarter turns. On a line the difference of the wheels adds
+		  up, see map_drive.
+		- the segment length is the distance driven from junction to
+		  junction, from the rotation counts, rounded to whole pitches
+		  (pitch, see world.h).
+
+	Each arrival at a junction records the junction and the line it
+	was reached by, in both directions. When the exit has been found,
+	the shortest path to the exit is found by a breadth first search
+	and can be replayed without exploring again.
+
+	Provides the functions:
+		- map_init: forget the map, start at the start junction
+		- map_drive: add the wheel rotations while following a line
+		- map_turn: update the heading after a turn at a junction
+		- map_junction: arrived at a junction
+		- map_exit: the exit strip leaves the current junction
+		- map_route: find the shortest path to the exit from the
+		  current junction
+		- map_next: the heading to take at the current junction
+		  when replaying the route
+		- map_cut: forget a line of the current junction which is
+		  not there
+
+	\author agent
+	\version 20261016
+
+	Changelog:
+		- 20261016 agent
+			- initial version
+			- pitch of the maze type told at the start
+			- lines not found when replaying are cut
+*/
+#ifndef MAP_H
+#define MAP_H 1
+
+#define MAP_NODES     128         //!< maximum number of junctions
+#define MAP_NONE      -1          //!< no junction
+
+// HEADINGS
+// quarter turns counter clockwise from the heading at the start
+#define HEADING_START    0x00     //!< heading at the start
+#define HEADING_LEFT     0x01     //!< a left turn from the start heading
+#define HEADING_BACK     0x02     //!< opposite of the start heading
+#define HEADING_RIGHT    0x03     //!< a right turn from the start heading
+
+// GLOBALS
+#ifdef NXTSIM
+int map_x[MAP_NODES];             //!< x position of the junctions (fixed size in C++)
+int map_y[MAP_NODES];             //!< y position of the junctions
+int map_adj[4 * MAP_NODES];       //!< junction reached from junction n in heading h at 4*n+h
+int map_prev[MAP_NODES];          //!< route search: junction it was reached from
+int map_queue[MAP_NODES];         //!< route search: junctions to visit
+byte map_route_heading[MAP_NODES]; //!< heading to take at each junction of the route
+#else
+int map_x[];                      //!< x position of the junctions
+int map_y[];                      //!< y position of the junctions
+int map_adj[];                    //!< junction reached from junction n in heading h at 4*n+h
+int map_prev[];                   //!< route search: junction it was reached from
+int map_queue[];                  //!< route search: junctions to visit
+byte map_route_heading[];         //!< heading to take at each junction of the route
+#endif
+int map_count = 0;                //!< number of junctions
+int map_node = 0;                 //!< the current junction
+int map_heading = HEADING_START;  //!< the current heading
+long map_length = 0;              //!< mm driven since the last junction
+long map_skew = 0;                //!< left minus right wheel degrees since the last turn
+int map_exit_node = MAP_NONE;     //!< junction with the exit strip
+int map_exit_heading = 0;         //!< heading of the exit strip
+bool map_full = false;            //!< more junctions than fit in the map
+
+//! \brief x offset of one pitch in heading h
+int map_dx (int h)
+{
+	if (h == HEADING_LEFT) return -1;
+	if (h == HEADING_RIGHT) return 1;
+	return 0;
+}
+// map_dx
+
+//! \brief y offset of one pitch in heading h
+int map_dy (int h)
+{
+	if (h == HEADING_START) return 1;
+	if (h == HEADING_BACK) return -1;
+	return 0;
+}
+// map_dy
+
+/*!
+	\brief Forgets the map
+
+	The start junction becomes junction 0 at (0,0).
+*/
+void map_init (void)
+{
+	ArrayInit(map_x, 0, MAP_NODES);
+	ArrayInit(map_y, 0, MAP_NODES);
+	ArrayInit(map_adj, MAP_NONE, 4 * MAP_NODES);
+	ArrayInit(map_prev, MAP_NONE, MAP_NODES);
+	ArrayInit(map_queue, 0, MAP_NODES);
+	ArrayInit(map_route_heading, 0, MAP_NODES);
+	map_count = 1;
+	map_node = 0;
+	map_heading = HEADING_START;
+	map_length = 0;
+	map_skew = 0;
+	map_exit_node = MAP_NONE;
+	map_full = false;
+}
+// map_init
+
+/*!
+	\brief Back at the start junction, keeping the map
+
+	Used before replaying a route.
+*/
+void map_restart (void)
+{
+	map_node = 0;
+	map_heading = HEADING_START;
+	map_length = 0;
+	map_skew = 0;
+}
+// map_restart
+
+//! \brief Finds the junction at (x,y), MAP_NONE if not mapped yet
+int map_find (int x, int y)
+{
+	for (int i = 0; i < map_count; i++) {
+		if ((map_x[i] == x) && (map_y[i] == y)) return i;
+	}
+	return MAP_NONE;
+}
+// map_find
+
+/*!
+	\brief Updates the heading after a turn at a junction
+
+	\param	degrees	Degrees turned, positive turns right
+*/
+void map_turn (int degrees)
+{
+	int quarters;
+	if (degrees >= 0) quarters = (degrees + 45) / 90;
+	else quarters = (degrees - 45) / 90;
+	map_heading = (map_heading - quarters) % 4;
+	if (map_heading < 0) map_heading += 4;
+	map_length = 0;
+	map_skew = 0;
+}
+// map_turn
+
+/*!
+	\brief Arrived at a junction
+
+	Moves to the junction the last segment leads to and records
+	the line between both.
+
+	\param	pass	mm driven to position the axis above the junction
+*/
+void map_junction (int pass)
+{
+	long steps = (map_length + pass + pitch / 2) / pitch;
+	map_length = 0;
+	// turned around on the line and back at the same junction
+	if (steps < 1) return;
+	int from = map_node;
+	int x = map_x[from] + steps * map_dx(map_heading);
+	int y = map_y[from] + steps * map_dy(map_heading);
+	int to = map_find(x, y);
+	if (to == MAP_NONE) {
+		if (map_count >= MAP_NODES) {
+			map_full = true;
+			return;
+		}
+		to = map_count;
+		map_x[to] = x;
+		map_y[to] = y;
+		map_count++;
+	}
+	map_adj[4 * from + map_heading] = to;
+	map_adj[4 * to + (map_heading + 2) % 4] = from;
+	map_node = to;
+}
+// map_junction
+
+/*!
+	\brief Adds the wheel rotations while following a line
+
+	The distance is added to the current segment. The difference of
+	the wheels is the angle turned, it adds up over the segment. Most
+	turns while following a line only correct the heading on the same
+	line. A quarter turn means the robot followed a corner at a
+	junction it did not see, the junction is added to the map. A half
+	turn means the robot turned around while searching the line and
+	drives back towards the junction it came from.
+
+	\param	left	Rotation count of the left wheel while following
+	\param	right	Rotation count of the right wheel while following
+*/
+void map_drive (long left, long right)
+{
+	map_length += ((left + right) * CIRC) / 720;
+	map_skew += left - right;
+	// degrees turned, positive turns right
+	long angle = (map_skew * DIAM) / (2 * CDIST);
+	int quarters;
+	if (angle >= 0) quarters = (angle + 45) / 90;
+	else quarters = (angle - 45) / 90;
+	if (quarters == 0) return;
+	map_skew -= (quarters * 180 * CDIST) / DIAM;
+	quarters = quarters % 4;
+	if (quarters < 0) quarters += 4;
+	if (quarters == HEADING_BACK) map_length = -map_length;
+	else map_junction(0);
+	map_heading = (map_heading - quarters + 4) % 4;
+}
+// map_drive
+
+//! \brief The exit strip leaves the current junction in the current heading
+void map_exit (void)
+{
+	map_exit_node = map_node;
+	map_exit_heading = map_heading;
+}
+// map_exit
+
+/*!
+	\brief Finds the shortest route from the current junction to the exit
+
+	Breadth first search over the mapped lines. Stores the
+	heading to take at each junction of the route. Searching again
+	at every junction gets the robot back on a route when it
+	missed a junction.
+
+	\return	true if there is a route
+*/
+bool map_route (void)
+{
+	if ((map_exit_node == MAP_NONE) || map_full) return false;
+	ArrayInit(map_prev, MAP_NONE, MAP_NODES);
+	int head = 0;
+	int tail = 1;
+	map_queue[0] = map_node;
+	map_prev[map_node] = map_node;
+	while ((head < tail) && (map_prev[map_exit_node] == MAP_NONE)) {
+		int n = map_queue[head];
+		head++;
+		for (int h = 0; h < 4; h++) {
+			int m = map_adj[4 * n + h];
+			if ((m != MAP_NONE) && (map_prev[m] == MAP_NONE)) {
+				map_prev[m] = n;
+				map_queue[tail] = m;
+				tail++;
+			}
+		}
+	}
+	if (map_prev[map_exit_node] == MAP_NONE) return false;
+	// walk back from the exit, storing the heading from each junction to its successor
+	int m = map_exit_node;
+	map_route_heading[m] = map_exit_heading;
+	while (m != map_node) {
+		int n = map_prev[m];
+		for (int h = 0; h < 4; h++) {
+			if (map_adj[4 * n + h] == m) map_route_heading[n] = h;
+		}
+		m = n;
+	}
+	return true;
+}
+// map_route
+
+//! \brief Heading to take at the current junction when replaying the route
+int map_next (void)
+{
+	return map_route_heading[map_node];
+}
+// map_next
+
+/*!
+	\brief Forgets the line in heading h of the current junction
+
+	A junction snapped to the wrong place while exploring links lines
+	which are not there. Replaying, the robot would search such a
+	line, find the one it came by and drive back and forth between
+	two junctions. The line is cut in both directions, the next
+	route search goes around it.
+
+	\param	h	heading of the line
+*/
+void map_cut (int h)
+{
+	int to = map_adj[4 * map_node + h];
+	if (to == MAP_NONE) return;
+	map_adj[4 * map_node + h] = MAP_NONE;
+	if (map_adj[4 * to + (h + 2) % 4] == map_node) map_adj[4 * to + (h + 2) % 4] = MAP_NONE;
+}
+// map_cut
+
+#endif // MAP_H
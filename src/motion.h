@@ -0,0 +1,219 @@
+/*! \file motion.h
+	\brief Motions run by a task of their own
+
+	RotateMotorMm and RotateBaseDegrees of libNBC.h block until the
+	robot stands still. The task motion runs queued motions instead,
+	such that the state machine can queue its next move and watch the
+	surface while the robot still moves:
+
+		- MOTION_DRIVE: straight on a number of mm, then brake
+		- MOTION_TURN: on the spot a number of degrees, positive
+		  turns right, then brake
+		- MOTION_ARC: a number of degrees of the outer wheel, the
+		  inner wheel slowed down by a turn percentage like OnFwdSync
+		- MOTION_STOP: brake, or leave the motors to the state machine
+
+	The motions are run one after the other. A drive ends on the
+	tacho limit of the firmware like RotateMotor, a turn like
+	RotateBaseDegrees with an instance of the task. Neither resets
+	the rotation counts, so the odometry of pose.h goes on
+	undisturbed. An arc runs on until its wheel has turned the
+	degrees or a stop is queued after it, and leaves the motors
+	running for the motion after it. Queued one after the other,
+	arcs run without stopping in between. The state machine watches
+	the surface while an arc runs and queues a stop where it wants
+	the arc to end. A stop without a brake leaves the motors running,
+	the state machine then runs them itself. While motions are
+	queued, the state machine must not run the drive motors.
+
+	The task is started once and runs for good like odometry. Each
+	motion is numbered when queued, motion_done counts the motions
+	finished, such that a motion is done when motion_done has reached
+	its number. The task owns the mutex moving and hands it over to
+	the tasks waiting in motion_wait after each motion, like observe
+	hands over sampled. While the queue is empty it waits for the
+	samples of observe and hands moving over after each, such that a
+	task which missed the end of a motion waits at most one period.
+
+	Provides the functions:
+		- motion_init: empty the queue, before the task is started
+		- motion_drive, motion_turn, motion_arc, motion_stop: queue
+		  a motion of a kind, its number
+		- motion_wait: block until a motion is done
+		- motion: the task that runs the motions
+
+	\author agent
+	\version 20261016
+
+	Changelog:
+		- 20261016 agent
+			- initial version
+			- the task runs for good, a motion queued while it was
+			  ending got lost
+			- turns, arcs and stops, the look turns and the arcs
+			  rolling through a junction are queued
+			- blocks on moving instead of polling the counters
+*/
+#ifndef MOTION_H
+#define MOTION_H 1
+
+// KINDS
+#define MOTION_DRIVE      0x01    //!< straight on
+#define MOTION_TURN       0x02    //!< on the spot
+#define MOTION_ARC        0x03    //!< on an arc
+#define MOTION_STOP       0x04    //!< brake or leave the motors
+
+#define MOTION_QUEUE      8       //!< motions queued at most
+#define MOTION_ENDLESS    0x7FFFFFFF //!< degrees of an arc ended by a stop only
+
+// GLOBALS
+#ifdef NXTSIM
+int motion_kind[MOTION_QUEUE];    //!< kind of each queued motion (fixed size in C++)
+int motion_pwr[MOTION_QUEUE];     //!< power of each queued motion, a stop brakes if not 0
+int motion_turnpct[MOTION_QUEUE]; //!< turn percentage of each queued arc
+long motion_degrees[MOTION_QUEUE]; //!< degrees of the wheels, or of the robot turning, of each queued motion
+#else
+int motion_kind[];                //!< kind of each queued motion
+int motion_pwr[];                 //!< power of each queued motion, a stop brakes if not 0
+int motion_turnpct[];             //!< turn percentage of each queued arc
+long motion_degrees[];            //!< degrees of the wheels, or of the robot turning, of each queued motion
+#endif
+long motion_queued = 0;           //!< motions queued, the number of the last one
+long motion_done = 0;             //!< motions finished
+mutex moved;                      //!< guards the queue between the state machine and motion
+mutex moving;                     //!< owned by motion, handed over after each motion
+
+RotateBaseDegreesInstance(motion)	// the instance of task motion
+
+//! \brief Empties the queue
+void motion_init (void)
+{
+	ArrayInit(motion_kind, MOTION_STOP, MOTION_QUEUE);
+	ArrayInit(motion_pwr, 0, MOTION_QUEUE);
+	ArrayInit(motion_turnpct, 0, MOTION_QUEUE);
+	ArrayInit(motion_degrees, 0, MOTION_QUEUE);
+	motion_queued = 0;
+	motion_done = 0;
+}
+// motion_init
+
+//! \brief True if the motion after the running one is a stop
+bool motion_stopped (void)
+{
+	Acquire(moved);
+	bool stop = (motion_queued > motion_done + 1) && (motion_kind[(motion_done + 1) % MOTION_QUEUE] == MOTION_STOP);
+	Release(moved);
+	return stop;
+}
+// motion_stopped
+
+/*!
+	\brief Runs the queued motions
+
+	A drive runs to the tacho limit and brakes, a turn runs like
+	RotateBaseDegrees. An arc starts the drive motors synchronized
+	and looks at the rotation counts after each sample of observe.
+	The counters are looked at without the mutex moved, only the
+	task changes motion_done.
+*/
+task motion (void)
+{
+	Acquire(moving);
+	while (true) {
+		while (motion_queued == motion_done) {
+			Release(moving);
+			Acquire(moving);
+			wait_sample();
+		}
+		Acquire(moved);
+		int i = motion_done % MOTION_QUEUE;
+		int kind = motion_kind[i];
+		int pwr = motion_pwr[i];
+		int turnpct = motion_turnpct[i];
+		long degrees = motion_degrees[i];
+		Release(moved);
+		if (kind == MOTION_DRIVE) {
+			RotateMotor(MOTOR_BOTH, pwr, degrees);
+			Off(MOTOR_BOTH);
+		}
+		else if (kind == MOTION_TURN) RotateBaseDegreesOn(motion, MOTOR_BOTH, pwr, degrees, DIAM, CDIST);
+		else if (kind == MOTION_ARC) {
+			long left = MotorRotationCount(MOTOR_LEFT);
+			long right = MotorRotationCount(MOTOR_RIGHT);
+			OnFwdSync(MOTOR_BOTH, pwr, turnpct);
+			until ((abs(MotorRotationCount(MOTOR_LEFT) - left) >= degrees) ||
+				(abs(MotorRotationCount(MOTOR_RIGHT) - right) >= degrees) ||
+				motion_stopped()) wait_sample();
+		}
+		else if (pwr != 0) Off(MOTOR_BOTH);
+		motion_done++;
+		Release(moving);
+		Acquire(moving);
+	}
+}
+// motion
+
+//! \brief Blocks until motion n is done
+void motion_wait (long n)
+{
+	while (motion_done < n) {
+		Acquire(moving);
+		Release(moving);
+	}
+}
+// motion_wait
+
+/*!
+	\brief Queues a motion, blocks while the queue is full
+
+	\param	kind	MOTION_DRIVE, MOTION_TURN, MOTION_ARC or MOTION_STOP
+	\param	pwr	power, negative drives backwards
+	\param	turnpct	turn percentage like OnFwdSync
+	\param	degrees	degrees of the wheels, of the robot turning
+	\return	the number of the motion
+*/
+long motion_queue (int kind, int pwr, int turnpct, long degrees)
+{
+	motion_wait(motion_queued - MOTION_QUEUE + 1);
+	Acquire(moved);
+	int i = motion_queued % MOTION_QUEUE;
+	motion_kind[i] = kind;
+	motion_pwr[i] = pwr;
+	motion_turnpct[i] = turnpct;
+	motion_degrees[i] = degrees;
+	motion_queued++;
+	long n = motion_queued;
+	Release(moved);
+	return n;
+}
+// motion_queue
+
+//! \brief Queues driving straight on mm at power pwr, the number of the motion
+long motion_drive (int pwr, int mm)
+{
+	return motion_queue(MOTION_DRIVE, pwr, 0, (abs(mm) * 360) / CIRC);
+}
+// motion_drive
+
+//! \brief Queues a turn on the spot, positive degrees turn right, the number of the motion
+long motion_turn (int pwr, int degrees)
+{
+	return motion_queue(MOTION_TURN, pwr, 0, degrees);
+}
+// motion_turn
+
+//! \brief Queues an arc of degrees of the outer wheel, the number of the motion
+long motion_arc (int pwr, int turnpct, long degrees)
+{
+	return motion_queue(MOTION_ARC, pwr, turnpct, degrees);
+}
+// motion_arc
+
+//! \brief Queues a stop, a brake if brake is true, the number of the motion
+long motion_stop (bool brake)
+{
+	return motion_queue(MOTION_STOP, brake ? 1 : 0, 0, 0);
+}
+// motion_stop
+
+#endif // MOTION_H
@@ -0,0 +1,167 @@
+/*! \file path.h
+	\brief Turns taken while exploring, reduced to the way to the exit
+
+	A lighter alternative to the map in map.h. Every turn the robot
+	takes is recorded as one symbol, the number of quarter turns to
+	the right:
+
+		- PATH_STRAIGHT: no turn
+		- PATH_RIGHT: a right turn
+		- PATH_BACK: a U-turn at a dead end, or on a line
+		- PATH_LEFT: a left turn
+
+	Dead ends are removed while recording. A U-turn between two turns
+	x B y means the robot came back to the junction of x and took y
+	from there. Both are replaced by the single turn x + 2 + y, e.g.
+	LBR = B, SBL = R or RBR = S. When the exit is found, the path
+	holds one turn for each junction on the way to the exit and can
+	be replayed without looking for the next way.
+
+	Provides the functions:
+		- path_init: forget the path
+		- path_add: record a turn, removing dead ends
+		- path_restart: replay from the first turn
+		- path_next: the turn to take at the next junction when
+		  replaying, PATH_NONE when the path is used up
+		- path_peek: like path_next, without taking the turn
+		- path_push: a turn to take at the next junction before
+		  going on with the path, see path_detour
+		- path_insert: like path_push, two U-turns cancel
+
+	\author agent
+	\version 20261016
+
+	Changelog:
+		- 20261016 agent
+			- initial version
+			- signature of the first turns
+			- peek at the next turn
+*/
+#ifndef PATH_H
+#define PATH_H 1
+
+#define PATH_SIZE       128       //!< maximum number of turns
+#define PATH_SIGN       6         //!< turns in the signature
+
+// TURNS
+// quarter turns to the right
+#define PATH_STRAIGHT   0x00      //!< go straight
+#define PATH_RIGHT      0x01      //!< turn right
+#define PATH_BACK       0x02      //!< turn around
+#define PATH_LEFT       0x03      //!< turn left
+#define PATH_NONE       0xFF      //!< no more turns
+
+// GLOBALS
+#ifdef NXTSIM
+byte path[PATH_SIZE];             //!< the turns (fixed size in C++)
+byte path_detour[PATH_SIZE];      //!< turns to take before going on with the path, the last one first
+#else
+byte path[];                      //!< the turns
+byte path_detour[];               //!< turns to take before going on with the path, the last one first
+#endif
+int path_count = 0;               //!< number of turns
+int path_pos = 0;                 //!< next turn when replaying
+int path_detours = 0;             //!< number of turns in path_detour
+bool path_full = false;           //!< more turns than fit in the path
+int path_turns = 0;               //!< turns recorded, with dead ends
+unsigned int path_sign = 0;       //!< the first PATH_SIGN turns, two bits each
+
+//! \brief Forgets the path
+void path_init (void)
+{
+	ArrayInit(path, PATH_STRAIGHT, PATH_SIZE);
+	ArrayInit(path_detour, PATH_STRAIGHT, PATH_SIZE);
+	path_count = 0;
+	path_pos = 0;
+	path_detours = 0;
+	path_full = false;
+	path_turns = 0;
+	path_sign = 0;
+}
+// path_init
+
+/*!
+	\brief Records a turn
+
+	The last three turns are reduced while the middle one is a
+	U-turn, such that the path never leads into a dead end.
+
+	\param	turn	quarter turns to the right
+*/
+void path_add (int turn)
+{
+	if (path_turns < PATH_SIGN) path_sign = path_sign * 4 + turn % 4;
+	path_turns++;
+	if (path_count >= PATH_SIZE) {
+		path_full = true;
+		return;
+	}
+	path[path_count] = turn % 4;
+	path_count++;
+	while ((path_count >= 3) && (path[path_count - 2] == PATH_BACK)) {
+		path[path_count - 3] = (path[path_count - 3] + PATH_BACK + path[path_count - 1]) % 4;
+		path_count -= 2;
+	}
+}
+// path_add
+
+//! \brief Replays the path from the start
+void path_restart (void)
+{
+	path_pos = 0;
+	path_detours = 0;
+}
+// path_restart
+
+//! \brief The next turn when replaying, PATH_NONE if there is none
+int path_next (void)
+{
+	if (path_detours > 0) {
+		path_detours--;
+		return path_detour[path_detours];
+	}
+	if (path_full || (path_pos >= path_count)) return PATH_NONE;
+	path_pos++;
+	return path[path_pos - 1];
+}
+// path_next
+
+//! \brief The next turn when replaying without taking it, PATH_NONE if there is none
+int path_peek (void)
+{
+	if (path_detours > 0) return path_detour[path_detours - 1];
+	if (path_full || (path_pos >= path_count)) return PATH_NONE;
+	return path[path_pos];
+}
+// path_peek
+
+/*!
+	\brief Takes a turn at the next junction before the ones pushed before
+
+	\param	turn	quarter turns to the right
+*/
+void path_push (int turn)
+{
+	if (path_detours >= PATH_SIZE) return;
+	path_detour[path_detours] = turn % 4;
+	path_detours++;
+}
+// path_push
+
+/*!
+	\brief Inserts a turn before the next one when replaying
+
+	Used when the robot turned around on a line. It gets back to
+	the junction it came from and has to turn around there. A U-turn
+	inserted on a U-turn cancels it, the robot already turned around.
+
+	\param	turn	quarter turns to the right
+*/
+void path_insert (int turn)
+{
+	if ((turn == PATH_BACK) && (path_detours > 0) && (path_detour[path_detours - 1] == PATH_BACK)) path_detours--;
+	else path_push(turn);
+}
+// path_insert
+
+#endif // PATH_H
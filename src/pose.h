@@ -0,0 +1,172 @@
+/*! \file pose.h
+	\brief Pose of the robot dead reckoned from the wheels
+
+	The task odometry integrates the rotation counts of both wheels
+	every POSE_PERIOD ms into the pose of the axis:
+
+		- pose_x, pose_y: position in 1/POSE_SCALE mm relative to the
+		  start junction, y along the start heading and x to the
+		  right of it, such that junction (x,y) of map.h is at
+		  (x*pitch, y*pitch)
+		- pose_heading: heading in 1/10 degree counter clockwise from
+		  the start heading, like the headings of map.h
+
+	The heading follows from the difference of the wheels since the
+	last snap, so rounding errors do not add up. The position adds
+	up the distance driven in each period along the mean heading of
+	the period, with the trigonometric functions of NXC, which take
+	whole degrees and are scaled by 100. Wheel slip and the error of
+	the metrics add up on the way, so the pose is snapped to the
+	junction the map says the robot is on, see pose_snap.
+
+	Provides the functions:
+		- pose_init: start at the start junction in the start heading
+		- pose_snap: set the pose to a known junction and heading
+		- pose_degrees: the heading in whole degrees
+		- pose_turn: degrees to turn right to a heading
+		- pose_ahead: mm the axis is ahead of a point along a heading
+		- odometry: the task that tracks the pose
+
+	\author agent
+	\version 20261016
+
+	Changelog:
+		- 20261016 agent
+			- initial version
+			- pose_rotate without holding the pose, the rotation
+			  counts are not reset
+			- pose_rotate removed, the task motion turns, see motion.h
+*/
+#ifndef POSE_H
+#define POSE_H 1
+
+#define POSE_SCALE      1000      //!< positions are in 1/POSE_SCALE mm
+#define POSE_PERIOD     10        //!< ms between two updates of the pose
+#define POSE_TURN       3600      //!< a full turn in units of pose_heading
+
+// GLOBALS
+long pose_x = 0;                  //!< x of the axis in 1/POSE_SCALE mm, right of the start heading
+long pose_y = 0;                  //!< y of the axis in 1/POSE_SCALE mm, along the start heading
+int pose_heading = 0;             //!< 1/10 degree counter clockwise from the start heading
+long pose_left = 0;               //!< rotation count of the left wheel at the last update
+long pose_right = 0;              //!< rotation count of the right wheel at the last update
+long pose_skew = 0;               //!< right minus left wheel in degrees since the last snap
+int pose_base = 0;                //!< pose_heading at the last snap
+mutex posed;                      //!< guards the pose between odometry and the state machine
+
+//! \brief An angle in 1/10 degree in the range 0 to POSE_TURN-1
+int pose_angle (long angle)
+{
+	angle = angle % POSE_TURN;
+	if (angle < 0) angle += POSE_TURN;
+	return angle;
+}
+// pose_angle
+
+//! \brief Heading in whole degrees counter clockwise from the start heading, 0 to 359
+int pose_degrees (void)
+{
+	return ((pose_heading + 5) / 10) % 360;
+}
+// pose_degrees
+
+/*!
+	\brief Integrates the wheels turned since the last update
+
+	Must be called with posed acquired.
+*/
+void pose_update (void)
+{
+	long left = MotorRotationCount(MOTOR_LEFT);
+	long right = MotorRotationCount(MOTOR_RIGHT);
+	long dl = left - pose_left;
+	long dr = right - pose_right;
+	pose_left = left;
+	pose_right = right;
+	int before = pose_heading;
+	pose_skew += dr - dl;
+	pose_heading = pose_angle(pose_base + (pose_skew * DIAM * 10) / (2 * CDIST));
+	// half way from the heading before to the heading now
+	int turned = pose_angle(pose_heading - before + POSE_TURN / 2) - POSE_TURN / 2;
+	int mid = (pose_angle(before + turned / 2) + 5) / 10;
+	long dist = ((dl + dr) * CIRC * POSE_SCALE) / 720;
+	pose_x -= (dist * Sin(mid)) / 100;
+	pose_y += (dist * Cos(mid)) / 100;
+}
+// pose_update
+
+/*!
+	\brief Degrees to turn right from the current heading to a heading
+
+	\param	degrees	the heading, counter clockwise from the start heading
+	\return	-180 to 179, negative to turn left
+*/
+int pose_turn (int degrees)
+{
+	Acquire(posed);
+	pose_update();
+	int right = pose_angle(pose_heading - 10 * degrees + POSE_TURN / 2) - POSE_TURN / 2;
+	Release(posed);
+	return right / 10;
+}
+// pose_turn
+
+/*!
+	\brief mm the axis is ahead of a point along a heading
+
+	\param	x, y	the point in mm
+	\param	degrees	the heading, counter clockwise from the start heading
+	\return	negative if the axis is short of the point
+*/
+long pose_ahead (long x, long y, int degrees)
+{
+	Acquire(posed);
+	pose_update();
+	long ahead = ((x - pose_x / POSE_SCALE) * Sin(degrees) + (pose_y / POSE_SCALE - y) * Cos(degrees)) / 100;
+	Release(posed);
+	return ahead;
+}
+// pose_ahead
+
+/*!
+	\brief Sets the pose
+
+	\param	x	x of the axis in mm
+	\param	y	y of the axis in mm
+	\param	degrees	heading counter clockwise from the start heading
+*/
+void pose_snap (long x, long y, int degrees)
+{
+	Acquire(posed);
+	pose_update();
+	pose_x = x * POSE_SCALE;
+	pose_y = y * POSE_SCALE;
+	pose_base = pose_angle(degrees * 10);
+	pose_skew = 0;
+	pose_heading = pose_base;
+	Release(posed);
+}
+// pose_snap
+
+//! \brief Starts at the start junction in the start heading
+void pose_init (void)
+{
+	pose_left = MotorRotationCount(MOTOR_LEFT);
+	pose_right = MotorRotationCount(MOTOR_RIGHT);
+	pose_snap(0, 0, 0);
+}
+// pose_init
+
+//! \brief Tracks the pose of the robot
+task odometry (void)
+{
+	while (true) {
+		Acquire(posed);
+		pose_update();
+		Release(posed);
+		Wait(POSE_PERIOD);
+	}
+}
+// odometry
+
+#endif // POSE_H
@@ -10,9 +10,11 @@
 	sensor should be used, this file needs to be adjusted.
 	
 	\author thomas.zink
-	\version 20101123
+	\version 20261016
 	
 	Changelog:
+		- 20261016 agent
+			- fixed size HT buffers when compiled for the simulator
 		- 20101123 thomas.zink
 			- moved to doxygen comments
 			- some port redefinitions
@@ -54,8 +56,13 @@
 #define SDIST   60     //!< distance of the axis to surface sensor
 
 // GLOBALS
+#ifdef NXTSIM
+byte htcmdbuf[3];      //!< command buffer for HT proto board (fixed size in C++)
+byte htrspbuf[3];      //!< response buffer for HT proto board
+#else
 byte htcmdbuf[];       //!< command buffer for HT proto board
 byte htrspbuf[];       //!< response buffer for HT proto board
+#endif
 int htcount = 0;       //!< counter for HT proto board
 
 /*!
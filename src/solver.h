@@ -0,0 +1,222 @@
+/*! \file solver.h
+	\brief Strategies choosing the way at a junction while exploring
+
+	The right hand rule needs no memory, look just takes the rightmost
+	line. It fails when the exit is inside a loop and walks every
+	dead end on its way. The strategies here keep the lines probed at
+	each junction in the grid of grid.h and choose a line from them:
+
+		- SOLVER_TREMAUX: marks the end of a line at a junction when
+		  arriving and when leaving on it. Takes an unmarked line if
+		  there is one, else one marked once, never one marked twice.
+		  Arriving at a visited junction by a new line closes a loop,
+		  the robot turns back.
+		- SOLVER_FLOOD: floods the lines known from the current
+		  junction and drives to the nearest junction not visited
+		  yet, the exit being somewhere unknown.
+
+	Both prefer lines in the order of the right hand rule: right,
+	straight, left, back. The marks are kept per end of a line, not
+	per line, since a line may bend through corners or span several
+	pitches of the map and need not end at the neighbour on the
+	grid. Junctions are at their map position plus
+	GRID_COLS/2, GRID_ROWS/2, such that mazes of up to 16 junctions
+	in any direction of the start fit.
+
+	The marks take two bits per line end, a byte per junction. The
+	flood keeps the direction each junction was reached in in four
+	bits, two junctions per byte like grid.h, and queues junctions in
+	a ring of SOLVER_QUEUE. A poster holds less than 50 junctions, so
+	the ring never fills on one. If it does, the flood gives up and
+	the right hand rule is used. All three take 1792 bytes.
+
+	Both find the exit of any maze that fits the grid, if the probe
+	sees every line. At a junction off the grid, or when the ring
+	fills, look falls back to the right hand rule, which may circle
+	a loop forever again.
+
+	Provides the functions:
+		- solver_init: forget all marks and junctions
+		- solver_mark: add a mark to the end of a line
+		- solver_choose: the direction to take at a junction
+
+	\author agent
+	\version 20261016
+
+	Changelog:
+		- 20261016 agent
+			- initial version
+			- flood directions packed, queue a ring
+			- limits of the solvers documented
+*/
+#ifndef SOLVER_H
+#define SOLVER_H 1
+
+// SOLVERS
+#define SOLVER_RIGHT      0x01    //!< right hand rule
+#define SOLVER_TREMAUX    0x02    //!< Tremaux marks
+#define SOLVER_FLOOD      0x03    //!< flood fill to the nearest unknown junction
+#define SOLVER_NONE       0xFF    //!< no direction, use the right hand rule
+
+#define SOLVER_CELLS      (GRID_COLS * GRID_ROWS)    //!< junctions of the grid
+#define SOLVER_FROM_BYTES (SOLVER_CELLS / 2)    //!< bytes of the flood directions
+#define SOLVER_QUEUE      128     //!< flood: junctions queued at most
+#define SOLVER_ROOT       0x05    //!< flood: the junction the flood starts at
+
+// GLOBALS
+#ifdef NXTSIM
+byte solver_marks[SOLVER_CELLS];  //!< marks of the four line ends of each junction, two bits each (fixed size in C++)
+byte solver_from[SOLVER_FROM_BYTES];    //!< flood: how two junctions were reached, four bits each
+int solver_queue[SOLVER_QUEUE];   //!< flood: ring of the junctions to visit
+#else
+byte solver_marks[];              //!< marks of the four line ends of each junction, two bits each
+byte solver_from[];               //!< flood: how two junctions were reached, four bits each
+int solver_queue[];               //!< flood: ring of the junctions to visit
+#endif
+
+//! \brief Forgets all marks and junctions
+void solver_init (void)
+{
+	grid_init();
+	ArrayInit(solver_marks, 0, SOLVER_CELLS);
+	ArrayInit(solver_from, 0, SOLVER_FROM_BYTES);
+	ArrayInit(solver_queue, 0, SOLVER_QUEUE);
+}
+// solver_init
+
+//! \brief x offset of one junction in direction dir
+int solver_dx (int dir)
+{
+	if (dir == GRID_DIR_WEST) return -1;
+	if (dir == GRID_DIR_EAST) return 1;
+	return 0;
+}
+// solver_dx
+
+//! \brief y offset of one junction in direction dir
+int solver_dy (int dir)
+{
+	if (dir == GRID_DIR_NORTH) return 1;
+	if (dir == GRID_DIR_SOUTH) return -1;
+	return 0;
+}
+// solver_dy
+
+//! \brief Marks of the line leaving junction (x,y) in direction dir, 0 off the grid
+int solver_marked (int x, int y, int dir)
+{
+	if (!grid_contains(x, y)) return 0;
+	return (solver_marks[y * GRID_COLS + x] >> (2 * dir)) & 0x03;
+}
+// solver_marked
+
+//! \brief Adds a mark to the line leaving junction (x,y) in direction dir, up to 3
+void solver_mark (int x, int y, int dir)
+{
+	if (!grid_contains(x, y) || (solver_marked(x, y, dir) == 3)) return;
+	int i = y * GRID_COLS + x;
+	solver_marks[i] = solver_marks[i] + (1 << (2 * dir));
+}
+// solver_mark
+
+/*!
+	\brief Tremaux: the direction to take at junction (x,y)
+
+	The line the robot arrived on must be marked already.
+
+	\param	heading	the heading the robot arrived in
+	\param	visited	the junction had been visited before
+*/
+int solver_tremaux (int x, int y, int heading, bool visited)
+{
+	int back = (heading + 2) % 4;
+	if (visited && (solver_marked(x, y, back) == 1)) return back;
+	for (int marks = 0; marks <= 1; marks++) {
+		// right, straight, left, back
+		for (int k = 3; k <= 6; k++) {
+			int dir = (heading + k) % 4;
+			if (grid_line(x, y, dir) && (solver_marked(x, y, dir) == marks)) return dir;
+		}
+	}
+	return back;
+}
+// solver_tremaux
+
+//! \brief Flood: 1 + direction junction i was reached in, SOLVER_ROOT for the first, 0 if not reached
+int solver_reached (int i)
+{
+	return (solver_from[i >> 1] >> ((i & 1) << 2)) & 0x0F;
+}
+// solver_reached
+
+//! \brief Flood: sets how junction i was reached, which must not be reached yet
+void solver_reach (int i, int from)
+{
+	solver_from[i >> 1] = solver_from[i >> 1] | (from << ((i & 1) << 2));
+}
+// solver_reach
+
+/*!
+	\brief Flood fill: the direction to the nearest junction not visited
+
+	Breadth first search over the lines of the grid.
+
+	\param	heading	the heading the robot arrived in
+	\return	the direction, SOLVER_NONE if all junctions reached are
+		visited or the queue is full
+*/
+int solver_flood (int x, int y, int heading)
+{
+	ArrayInit(solver_from, 0, SOLVER_FROM_BYTES);
+	int from = y * GRID_COLS + x;
+	int head = 0;
+	int tail = 1;
+	solver_queue[0] = from;
+	solver_reach(from, SOLVER_ROOT);
+	while (head < tail) {
+		int i = solver_queue[head % SOLVER_QUEUE];
+		head++;
+		int cx = i % GRID_COLS;
+		int cy = i / GRID_COLS;
+		if ((i != from) && !(grid_get(cx, cy) & GRID_VISITED)) {
+			// walk back to the first line
+			int dir = solver_reached(i) - 1;
+			while (i - solver_dx(dir) - GRID_COLS * solver_dy(dir) != from) {
+				i = i - solver_dx(dir) - GRID_COLS * solver_dy(dir);
+				dir = solver_reached(i) - 1;
+			}
+			return dir;
+		}
+		// right, straight, left, back
+		for (int k = 3; k <= 6; k++) {
+			int dir = (heading + k) % 4;
+			int j = i + solver_dx(dir) + GRID_COLS * solver_dy(dir);
+			if (grid_line(cx, cy, dir) && (solver_reached(j) == 0)) {
+				if (tail - head >= SOLVER_QUEUE) return SOLVER_NONE;
+				solver_reach(j, dir + 1);
+				solver_queue[tail % SOLVER_QUEUE] = j;
+				tail++;
+			}
+		}
+	}
+	return SOLVER_NONE;
+}
+// solver_flood
+
+/*!
+	\brief The direction to take at junction (x,y)
+
+	\param	solver	SOLVER_TREMAUX or SOLVER_FLOOD
+	\param	heading	the heading the robot arrived in
+	\param	visited	the junction had been visited before
+	\return	the direction, SOLVER_NONE for the right hand rule
+*/
+int solver_choose (int solver, int x, int y, int heading, bool visited)
+{
+	if (solver == SOLVER_TREMAUX) return solver_tremaux(x, y, heading, visited);
+	if (solver == SOLVER_FLOOD) return solver_flood(x, y, heading);
+	return SOLVER_NONE;
+}
+// solver_choose
+
+#endif // SOLVER_H
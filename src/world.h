@@ -12,14 +12,45 @@
 	
 	The Robot performs the following task in the world:
 		- observe (observe the surface)
-	
-	Note that depending on MAZE_TYPE definitions of constants and
-	tasks differ.
+
+	observe samples the surface at a fixed period and publishes
+	each change with a sequence number and its tick. Other tasks
+	block in wait_sample or wait_change until there is something
+	new instead of spinning on `surface`, which left the VM to
+	two busy loops and delayed the reaction to a change. The
+	surface is voted from the last few samples, see observe.
+
+	Lines are followed along their left edge, where the light sensor
+	sees line and background. The light at the edge is tedge, the
+	gains of the PID follower are kp, ki and kd in 1/PID_SCALE power
+	per percent of light. They differ with the contrast of the maze
+	type. The surface is told from both sensors, see sense.
+
+	At the start calibrate measures the light of line, background
+	and junction, tells the maze type from them and sets the
+	thresholds. MAZE_TYPE is the type assumed before, and kept if
+	calibration is off or fails. The gains and metrics of each type
+	are defined here, world_select switches between them.
+
+	Rolling through junctions is only enabled on white, where it
+	measured faster.
 	
 	\author thomas.zink
-	\version 20101123
+	\version 20261016
 	
 	Changelog:
+		- 20261016 agent
+			- MAZE_TYPE can be set from the command line
+			- edge light and PID gains to follow lines
+			- smaller integral gain on the color mazes
+			- observe samples at a fixed period and signals changes
+			- observe votes the surface from a window of samples
+			- observe keeps the confidence of the surface
+			- sense fuses the color and the light sensor
+			- calibrate sets the thresholds and tells the maze type
+			- width of the junctions and rolling of the maze type told
+			- the gray mazes stop at junctions
+			- only the white mazes roll, documented why
 		- 20110517 thomas.zink
 			- work on comments
 		- 20101123 thomas.zink
@@ -38,7 +69,9 @@
 #define MAZE_WHITE    0x01             //!< old-style maze with white background
 #define MAZE_GRAY     0x02             //!< new-style maze with gray background
 #define MAZE_COLOR    0x03             //!< brand-new color mazes
-#define MAZE_TYPE     MAZE_COLOR       //!< maze type used
+#ifndef MAZE_TYPE
+#define MAZE_TYPE     MAZE_COLOR       //!< maze type assumed until calibrated
+#endif
 
 // SURFACE
 // what surface the robot observes
@@ -47,8 +80,38 @@
 #define SURFACE_EXIT    0x03          //!< above the exit (hoooray)
 #define SURFACE_NDEF    0x04          //!< everything else is undefined
 byte surface;                         //!< set by observe to one of the surface definitions
+unsigned int surface_seq = 0;         //!< number of changes of surface
+unsigned long surface_tick = 0;       //!< tick of the last change of surface
+unsigned int surface_conf = 0;        //!< percent of the samples in the window which agree with surface
+mutex sampled;                        //!< owned by observe, handed over after each sample
+
+// OBSERVING
+#define OBSERVE_PERIOD  3             //!< ms between two samples, the analog sample period
+int period = OBSERVE_PERIOD;          //!< ms between two samples of observe
+#define OBSERVE_MAX     8             //!< maximum number of samples in the window
+#define OBSERVE_VOTES   1             //!< samples of the window to change to a defined surface, see observe
+#ifdef NXTSIM
+byte observed[OBSERVE_MAX];           //!< ring of the last samples (fixed size in C++)
+#else
+byte observed[];                      //!< ring of the last samples
+#endif
+
+// LINE FOLLOWING
+#define PID_SCALE       16            //!< gains are in 1/PID_SCALE power per percent of light
+#define EDGE_SHARE      6             //!< the edge is 1/EDGE_SHARE of the way from line to background light
+
+// LIGHT
+#define LIGHT_DELTA     5             //!< bias to adjust light values
+#define LIGHT_MAX       100           //!< maximum reflected light
+
+// COLORS
+// HT color numbers
+#define HUE_BLACK       0             //!< black
+#define HUE_BLUE_MIN    2             //!< first blue
+#define HUE_BLUE_MAX    3             //!< last blue
+#define HUE_RED_MIN     7             //!< first red
+#define HUE_RED_MAX     10            //!< last red
 
-#if MAZE_TYPE == MAZE_WHITE
 /*
 	MAZE_WHITE
 	background: white
@@ -56,135 +119,443 @@ byte surface;                         //!< set by observe to one of the surface
 	junctions: black
 	exit: black
 */
-// LIGHT
-#define LIGHT_DELTA    5     //!< bias to adjust light values
-#define LIGHT_JUNC     33    //!< reflected light on junction
-#define LIGHT_LINE     50    //!< reflected light on line
+#define WHITE_JUNC      33    //!< reflected light on junction
+#define WHITE_LINE      50    //!< reflected light on line
+#define WHITE_BACK      62    //!< reflected light on background
+#define WHITE_KP        250   //!< proportional gain
+#define WHITE_KI        4     //!< integral gain
+#define WHITE_KD        0     //!< derivative gain
+#define WHITE_WINDOW    3     //!< samples classified together
+#define WHITE_ROLL      1     //!< rolls through junctions, straight and turning
+#define WHITE_LEN_JUNC  35    //!< length of a junction
+#define WHITE_WID_JUNC  35    //!< width of a junction
+#define WHITE_LEN_LINE  141   //!< length of a line
+#define WHITE_WID_LINE  17    //!< width of a line
 
-int tjunc = LIGHT_JUNC + LIGHT_DELTA;    //!< light threshold for junctions
-int tline = LIGHT_LINE - LIGHT_DELTA;    //!< light threshold for lines
-int tndef = LIGHT_LINE + LIGHT_DELTA;    //!< light threshold for undefined
+/*
+	MAZE_GRAY
+	background: gray
+	lines: white
+	junctions: black
+	exit: black
+*/
+#define GRAY_JUNC       40    //!< reflected light on junction
+#define GRAY_LINE       67    //!< reflected light on line
+#define GRAY_BACK       52    //!< reflected light on background
+#define GRAY_KP         250   //!< proportional gain
+#define GRAY_KI         8     //!< integral gain
+#define GRAY_KD         64    //!< derivative gain
+#define GRAY_WINDOW     3     //!< samples classified together
+#define GRAY_ROLL       0     //!< stops at junctions, see above
+#define GRAY_LEN_JUNC   27    //!< length of a junction
+#define GRAY_WID_JUNC   27    //!< width of a junction
+#define GRAY_LEN_LINE   113   //!< length of a line
+#define GRAY_WID_LINE   21    //!< width of a line
+
+/*
+	MAZE_COLOR
+	background: white
+	lines: black
+	junctions: red
+	exit: blue
+*/
+#define COLOR_JUNC      47    //!< reflected light on junction, told by its hue
+#define COLOR_LINE      28    //!< reflected light on line
+#define COLOR_BACK      62    //!< reflected light on background
+#define COLOR_KP        160   //!< proportional gain
+#define COLOR_KI        4     //!< integral gain, low since observe waits for the color sensor
+#define COLOR_KD        0     //!< derivative gain
+#define COLOR_WINDOW    4     //!< samples classified together
+#define COLOR_ROLL      0     //!< stops at junctions, see above
+#define COLOR_LEN_JUNC  30    //!< length of a junction
+#define COLOR_WID_JUNC  30    //!< width of a junction
+#define COLOR_LEN_LINE  110   //!< length of a line
+#define COLOR_WID_LINE  20    //!< width of a line
 
-// METRICS
-#define LEN_JUNC    35       //!< length of a junction
-#define WID_JUNC    35       //!< width of a junction
-#define LEN_LINE    141      //!< length of a line
-#define WID_LINE    17       //!< width of a line
+// CALIBRATION
+#define CALIB_SPEED     SPEED_MEDIUM  //!< speed of the calibration sweep
+#define CALIB_SWEEP     35            //!< degrees to turn each way from the line
+#define CALIB_OFF       20            //!< degrees off the line from where the background is seen
+#define CALIB_SAMPLES   8             //!< samples of the line and of the junction
+#define CALIB_CONTRAST  8             //!< least light difference of two surfaces, most of one
+int calib = 1;                        //!< calibrate at the start, 0 keeps the compiled type and thresholds
+long calib_sum = 0;                   //!< sum of the light seen off the line while sweeping
+int calib_count = 0;                  //!< samples seen off the line while sweeping
+int calib_lo = 0;                     //!< darkest light seen off the line while sweeping
+int calib_hi = 0;                     //!< brightest light seen off the line while sweeping
+
+/**************************************************************************/
+// COMPILED TYPE
+// the maze type assumed until calibrate tells it
+#if MAZE_TYPE == MAZE_WHITE
+#define LIGHT_JUNC      WHITE_JUNC
+#define LIGHT_LINE      WHITE_LINE
+#define LIGHT_BACK      WHITE_BACK
+#define LIGHT_TJUNC     (WHITE_JUNC + LIGHT_DELTA)
+#define LIGHT_TLINE     (WHITE_LINE - LIGHT_DELTA)
+#define LIGHT_TNDEF     (WHITE_LINE + LIGHT_DELTA)
+#define PID_KP          WHITE_KP
+#define PID_KI          WHITE_KI
+#define PID_KD          WHITE_KD
+#define OBSERVE_WINDOW  WHITE_WINDOW
+#define ROLL            WHITE_ROLL
+#define LEN_JUNC        WHITE_LEN_JUNC
+#define WID_JUNC        WHITE_WID_JUNC
+#define LEN_LINE        WHITE_LEN_LINE
+#define WID_LINE        WHITE_WID_LINE
+#endif	// MAZE_WHITE
+#if MAZE_TYPE == MAZE_GRAY
+#define LIGHT_JUNC      GRAY_JUNC
+#define LIGHT_LINE      GRAY_LINE
+#define LIGHT_BACK      GRAY_BACK
+#define LIGHT_TJUNC     (GRAY_JUNC + LIGHT_DELTA)
+#define LIGHT_TLINE     (GRAY_LINE - LIGHT_DELTA)
+#define LIGHT_TNDEF     (LIGHT_MAX + 1)
+#define PID_KP          GRAY_KP
+#define PID_KI          GRAY_KI
+#define PID_KD          GRAY_KD
+#define OBSERVE_WINDOW  GRAY_WINDOW
+#define ROLL            GRAY_ROLL
+#define LEN_JUNC        GRAY_LEN_JUNC
+#define WID_JUNC        GRAY_WID_JUNC
+#define LEN_LINE        GRAY_LEN_LINE
+#define WID_LINE        GRAY_WID_LINE
+#endif	// MAZE_GRAY
+#if MAZE_TYPE == MAZE_COLOR
+#define LIGHT_JUNC      COLOR_JUNC
+#define LIGHT_LINE      COLOR_LINE
+#define LIGHT_BACK      COLOR_BACK
+#define LIGHT_TJUNC     0
+#define LIGHT_TLINE     -1
+#define LIGHT_TNDEF     ((COLOR_LINE + COLOR_BACK) / 2)
+#define PID_KP          COLOR_KP
+#define PID_KI          COLOR_KI
+#define PID_KD          COLOR_KD
+#define OBSERVE_WINDOW  COLOR_WINDOW
+#define ROLL            COLOR_ROLL
+#define LEN_JUNC        COLOR_LEN_JUNC
+#define WID_JUNC        COLOR_WID_JUNC
+#define LEN_LINE        COLOR_LEN_LINE
+#define WID_LINE        COLOR_WID_LINE
+#endif	// MAZE_COLOR
+
+int maze_type = MAZE_TYPE;                   //!< the maze type, told by calibrate
+int light_junc = LIGHT_JUNC;                 //!< reflected light on junction
+int light_line = LIGHT_LINE;                 //!< reflected light on line
+int light_back = LIGHT_BACK;                 //!< reflected light on background
+int tjunc = LIGHT_TJUNC;                     //!< light threshold for junctions
+int tline = LIGHT_TLINE;                     //!< light threshold for lines
+int tndef = LIGHT_TNDEF;                     //!< light threshold for undefined
+int tedge = LIGHT_LINE + (LIGHT_BACK - LIGHT_LINE) / EDGE_SHARE;    //!< light to keep following a line
+int kp = PID_KP;                             //!< proportional gain
+int ki = PID_KI;                             //!< integral gain
+int kd = PID_KD;                             //!< derivative gain
+int window = OBSERVE_WINDOW;                 //!< samples classified together, at most OBSERVE_MAX
+int roll = ROLL;                             //!< 1 rolls through the junctions of a known way, 0 stops at each
+int pitch = LEN_JUNC + LEN_LINE;             //!< distance of two junctions in mm
+int wid_junc = WID_JUNC;                     //!< width of a junction in mm
 
 /*!
-	\brief Observe the surface
-	
-	Checks the surface and sets the global variable `surface`
-	to the value corresponding to the tone the sensor
-	sees.
-	\see surface
+	\brief Switches to the settings of another maze type
+
+	Sets what is not measured by calibrate: the gains of the line
+	follower, the samples classified together, whether to roll
+	through junctions, the pitch and the width of the junctions. The
+	settings of the compiled type are kept, such that they can be
+	tuned.
 */
-task observe (void)
+void world_select (int type)
 {
-	int light;
-	while (true) {
-		light = LIGHT_VALUE;
-		if (light < tjunc) surface = SURFACE_JUNC;
-		else if ((light > tline) && (light < tndef)) surface = SURFACE_LINE;
-		else surface = SURFACE_NDEF;
+	if (type == maze_type) return;
+	maze_type = type;
+	if (type == MAZE_WHITE) {
+		kp = WHITE_KP;
+		ki = WHITE_KI;
+		kd = WHITE_KD;
+		window = WHITE_WINDOW;
+		roll = WHITE_ROLL;
+		pitch = WHITE_LEN_JUNC + WHITE_LEN_LINE;
+		wid_junc = WHITE_WID_JUNC;
+	}
+	else if (type == MAZE_GRAY) {
+		kp = GRAY_KP;
+		ki = GRAY_KI;
+		kd = GRAY_KD;
+		window = GRAY_WINDOW;
+		roll = GRAY_ROLL;
+		pitch = GRAY_LEN_JUNC + GRAY_LEN_LINE;
+		wid_junc = GRAY_WID_JUNC;
+	}
+	else {
+		kp = COLOR_KP;
+		ki = COLOR_KI;
+		kd = COLOR_KD;
+		window = COLOR_WINDOW;
+		roll = COLOR_ROLL;
+		pitch = COLOR_LEN_JUNC + COLOR_LEN_LINE;
+		wid_junc = COLOR_WID_JUNC;
 	}
 }
-// observe
+// world_select
 
-#endif	// MAZE_WHITE
-/**************************************************************************/
-#if MAZE_TYPE == MAZE_GRAY
-/*
-	MAZE_GRAY
-	background: gray
-	lines: white
-	junctions: black
-	exit: black
+/*!
+	\brief The surface told by the reflected light
+
+	Lines are between tline and tndef. On the color mazes the light
+	tells no junctions, tjunc is 0.
 */
-// LIGHT
-#define LIGHT_DELTA    5     //!< bias to adjust light values
-#define LIGHT_JUNC     40    //!< reflected light on junction
-#define LIGHT_LINE     67    //!< reflected light on line
+byte sense_light (int light)
+{
+	if (light < tjunc) return SURFACE_JUNC;
+	if ((light > tline) && (light < tndef)) return SURFACE_LINE;
+	return SURFACE_NDEF;
+}
+// sense_light
 
-int tjunc = LIGHT_JUNC + LIGHT_DELTA; //!< light threshold for junctions
-int tline = LIGHT_LINE - LIGHT_DELTA; //!< light threshold for lines
+/*!
+	\brief The surface told by the HT color number
 
-// METRICS
-#define LEN_JUNC    27        //!< length of a junction
-#define WID_JUNC    27        //!< width of a junction
-#define LEN_LINE    113       //!< length of a line
-#define WID_LINE    21        //!< width of a line
+	On the white and gray mazes only junctions and the exit have a
+	hue, they are both black.
+*/
+byte sense_color (int color)
+{
+	if (maze_type != MAZE_COLOR) {
+		if (color == HUE_BLACK) return SURFACE_JUNC;
+		return SURFACE_NDEF;
+	}
+	if (color == HUE_BLACK) return SURFACE_LINE;
+	if ((color >= HUE_BLUE_MIN) && (color <= HUE_BLUE_MAX)) return SURFACE_EXIT;
+	if ((color >= HUE_RED_MIN) && (color <= HUE_RED_MAX)) return SURFACE_JUNC;
+	return SURFACE_NDEF;
+}
+// sense_color
+
+/*!
+	\brief The surface under the sensor
+
+	Reads both sensors and fuses what they tell. The hue of the HT
+	color sensor tells junctions and the exit, the reflected light
+	of the light sensor tells the edge of a line, where the spot
+	sees a mix of line and background which has no color number.
+	The color is read first, it is sampled at the start of the I2C
+	transaction, such that both readings are of about the same
+	spot.
+	\see surface
+*/
+byte sense (void)
+{
+	byte hue = sense_color(COLOR_VALUE);
+	byte tone = sense_light(LIGHT_VALUE);
+	if ((hue == SURFACE_JUNC) || (hue == SURFACE_EXIT)) return hue;
+	if (tone != SURFACE_NDEF) return tone;
+	return hue;
+}
+// sense
 
 /*!
 	\brief Observe the surface
 	
-	Checks the surface and sets the global variable `surface`
-	to the value corresponding to the tone the sensor
-	sees.
+	Samples the surface every period ms and keeps the last
+	window samples in a ring. The surface changes to a
+	defined surface when OBSERVE_VOTES samples of the window agree,
+	and to SURFACE_NDEF only when all of them do. The debounce is
+	on the way to SURFACE_NDEF only: an odd sample at the edge of a
+	line, or a speck on the poster, reads the background, so it
+	does not send the robot searching. Junctions and the exit do
+	not come from mixing at the edges, OBSERVE_VOTES is 1 such that
+	a sample of them is taken at once and the robot stops on a
+	junction within a few mm. A change of the surface is published
+	in `surface`, then counted in surface_seq and stamped in
+	surface_tick. surface_conf is the share of the window which
+	agrees with the surface, counted in the same pass over the
+	window, 100 when all samples agree. After each sample the mutex
+	sampled is handed over to the tasks waiting for it, such that
+	they need not poll `surface` meanwhile. Handing it over with
+	every sample rather than only with changes means a task which
+	missed a change waits at most one period.
 	\see surface
 */
 task observe (void)
 {
-	int light;
+	ArrayInit(observed, SURFACE_NDEF, OBSERVE_MAX);
+	int at = 0;
+	Acquire(sampled);
+	long next = CurrentTick();
 	while (true) {
-		light = LIGHT_VALUE;
-		if (light < tjunc) surface = SURFACE_JUNC;
-		else if (light > tline) surface = SURFACE_LINE;
-		else surface = SURFACE_NDEF;
+		byte now = sense();
+		observed[at] = now;
+		at = (at + 1) % window;
+		// samples of the window which are now and which are the surface
+		int is = now;
+		int was = surface;
+		int votes = 0;
+		int agree = 0;
+		for (int i = 0; i < window; i++) {
+			int seen = observed[i];
+			if (seen == is) votes++;
+			if (seen == was) agree++;
+		}
+		if ((is != was) && ((votes == window) || ((is != SURFACE_NDEF) && (votes >= OBSERVE_VOTES)))) {
+			surface = now;
+			surface_tick = CurrentTick();
+			surface_seq++;
+			agree = votes;
+		}
+		surface_conf = (100 * agree) / window;
+		Release(sampled);
+		Acquire(sampled);
+		next += period;
+		long left = next - CurrentTick();
+		if (left > 0) Wait(left);
+		else next = CurrentTick();
 	}
 }
 // observe
 
-#endif 	// MAZE_GRAY
-/**************************************************************************/
-#if MAZE_TYPE == MAZE_COLOR
-/*
-	MAZE_COLOR
-	background: white
-	lines: black
-	junctions: red
-	exit: blue
+//! \brief Blocks until observe has taken the next sample
+void wait_sample (void)
+{
+	Acquire(sampled);
+	Release(sampled);
+}
+// wait_sample
+
+/*!
+	\brief Blocks until the surface changes
+
+	Read surface_seq before looking at `surface`, such that a
+	change in between is not missed.
+
+	\param	seq	surface_seq before `surface` was looked at
+	\return	the new surface_seq
 */
-// METRICS
-#define LEN_JUNC    30        //!< length of a junction
-#define WID_JUNC    30        //!< width of a junction
-#define LEN_LINE    110       //!< length of a line
-#define WID_LINE    20        //!< width of a line
+unsigned int wait_change (unsigned int seq)
+{
+	while (surface_seq == seq) wait_sample();
+	return surface_seq;
+}
+// wait_change
 
 /*!
-	\brief Observe the surface
-	
-	Checks the surface and sets the global variable `surface`
-	to the value corresponding to the tone the sensor
-	sees.
-	\see surface
+	\brief Mean light of samples taken standing still
+
+	\param	spread	set to the difference of the brightest and the
+			darkest sample
 */
-task observe (void)
+int calib_light (int &spread)
 {
-	int color;
-	while (true) {
-		color = COLOR_VALUE;
-		switch (color) {
-			case 0:
-				surface = SURFACE_LINE;
-				break;
-			case 2:
-			case 3:
-				surface = SURFACE_EXIT;
-				break;
-			case 7:
-			case 8:
-			case 9:
-			case 10:
-				surface = SURFACE_JUNC;
-				break;
-			default:
-				surface = SURFACE_NDEF;
-				break;
+	int sum = 0;
+	int lo = LIGHT_MAX;
+	int hi = 0;
+	for (int i = 0; i < CALIB_SAMPLES; i++) {
+		int light = LIGHT_VALUE;
+		sum += light;
+		if (light < lo) lo = light;
+		if (light > hi) hi = light;
+		Wait(OBSERVE_PERIOD);
+	}
+	spread = hi - lo;
+	return (sum + CALIB_SAMPLES / 2) / CALIB_SAMPLES;
+}
+// calib_light
+
+/*!
+	\brief Turns on the spot to an angle, adding up the light off the line
+
+	\param	angle	degrees from the start heading, positive right
+	\param	origin	rotation count of the left wheel at the start heading
+*/
+void calib_turn (int angle, long origin)
+{
+	long target = (angle * CDIST) / DIAM;
+	long off = (CALIB_OFF * CDIST) / DIAM;
+	int dir = 100;
+	if (target < MotorRotationCount(MOTOR_LEFT) - origin) dir = -100;
+	OnFwdSync(MOTOR_BOTH, CALIB_SPEED, dir);
+	while (dir * (target - (MotorRotationCount(MOTOR_LEFT) - origin)) > 0) {
+		int light = LIGHT_VALUE;
+		if (abs(MotorRotationCount(MOTOR_LEFT) - origin) >= off) {
+			calib_sum += light;
+			calib_count++;
+			if (light < calib_lo) calib_lo = light;
+			if (light > calib_hi) calib_hi = light;
 		}
+		Wait(OBSERVE_PERIOD);
 	}
+	Off(MOTOR_BOTH);
 }
-// observe
-#endif	// MAZE_COLOR
+// calib_turn
+
+/*!
+	\brief Calibrates the light thresholds and tells the maze type
+
+	The robot stands on the start junction, the sensor on the line
+	leaving it. Measures the mean light of the line, then sweeps
+	CALIB_SWEEP degrees to either side and back, where the sensor
+	sees the background, then backs up until the sensor is above
+	the junction and measures it, and drives forward again.
+
+	The hue of the junction tells the color mazes, red, from the
+	others, black. Of these the gray mazes have lines brighter than
+	the background. The thresholds are set between the mean light
+	of the surfaces, like the compiled ones. If the samples of a
+	surface spread too much, or two surfaces differ too little, the
+	compiled type and thresholds are kept.
+
+	\return	true if the thresholds and the type have been set
+*/
+bool calibrate (void)
+{
+	if (!calib) return false;
+	int spread;
+	long origin = MotorRotationCount(MOTOR_LEFT);
+	int line = calib_light(spread);
+	bool ok = spread < CALIB_CONTRAST;
+	calib_sum = 0;
+	calib_count = 0;
+	calib_lo = LIGHT_MAX;
+	calib_hi = 0;
+	calib_turn(CALIB_SWEEP, origin);
+	calib_turn(-CALIB_SWEEP, origin);
+	calib_turn(0, origin);
+	RotateMotorMm(MOTOR_BOTH, CALIB_SPEED, -SDIST, CIRC);
+	int junc = calib_light(spread);
+	ok = ok && (spread < CALIB_CONTRAST);
+	int hue = COLOR_VALUE;
+	RotateMotorMm(MOTOR_BOTH, CALIB_SPEED, SDIST, CIRC);
+	if (!ok || (calib_count == 0) || (calib_hi - calib_lo >= CALIB_CONTRAST)) return false;
+	int back = (calib_sum + calib_count / 2) / calib_count;
+	if (abs(back - line) < CALIB_CONTRAST) return false;
+	// tell the type
+	int type = MAZE_WHITE;
+	if ((hue >= HUE_RED_MIN) && (hue <= HUE_RED_MAX)) type = MAZE_COLOR;
+	else if (hue != HUE_BLACK) return false;
+	else if (line > back) type = MAZE_GRAY;
+	if ((type != MAZE_COLOR) && ((line - junc < CALIB_CONTRAST) || (back - junc < CALIB_CONTRAST))) return false;
+	// set the thresholds
+	world_select(type);
+	light_junc = junc;
+	light_line = line;
+	light_back = back;
+	if (type == MAZE_WHITE) {
+		tjunc = junc + (line - junc) / 3;
+		tline = line - (line - junc) / 3;
+		tndef = (line + back) / 2;
+	}
+	else if (type == MAZE_GRAY) {
+		tjunc = (junc + back) / 2;
+		tline = (back + line) / 2;
+		tndef = LIGHT_MAX + 1;
+	}
+	else {
+		tjunc = 0;
+		tline = -1;
+		tndef = (line + back) / 2;
+	}
+	tedge = line + (back - line) / EDGE_SHARE;
+	return true;
+}
+// calibrate
 
 #endif // WORLD_H
@@ -0,0 +1,688 @@
+/*! \file testsim.cpp
+	\brief Test cases for the simulator
+
+	Runs the maze solver on the demo maze for all maze types
+	and checks that it gets out and that runs are repeatable.
+	Checks that maze files load and survive a round trip through
+	both formats and that generated mazes are repeatable, connected
+	and solved. Checks that parameters are applied and that batches
+	give the same results on any number of threads. Checks that the
+	route mapped while exploring and the path of turns are replayed
+	faster, and that routes learned in flash are used after a
+	restart. Compares the packed grid with a naive one. Checks that the robot
+	stops soon after the surface changes but not at odd samples,
+	and later when observe samples less often. Checks that the program
+	of any maze type tells the type of the poster and that calibration
+	makes up for ambient light, and that the pose tracked by odometry
+	stays close to the true pose, and that look turns less than
+	sweeping the junctions, that replays rolling through junctions
+	are faster and that slowing down before junctions takes effect
+	and still gets out. Must be run from the top directory.
+*/
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <unistd.h>
+#include "batch.h"
+#include "generator.h"
+#include "packed.h"
+#include "runtime.h"
+
+using namespace sim;
+
+static int failures = 0;    //!< number of failed checks
+
+//! \brief Reports a failed check
+static void check (bool ok, const char *what, int type, unsigned long long seed)
+{
+	if (ok) return;
+	printf("FAIL %s (type %d, seed %llu)\n", what, type, seed);
+	failures++;
+}
+// check
+
+//! \brief True if two mazes are equal
+static bool same (const Maze &a, const Maze &b)
+{
+	if ((a.type() != b.type()) || (a.cols() != b.cols()) || (a.rows() != b.rows())) return false;
+	if ((a.start_x() != b.start_x()) || (a.start_y() != b.start_y()) || (a.start_dir() != b.start_dir())) return false;
+	if ((a.exit_x() != b.exit_x()) || (a.exit_y() != b.exit_y()) || (a.exit_dir() != b.exit_dir())) return false;
+	for (int y = 0; y < a.rows(); y++)
+		for (int x = 0; x < a.cols(); x++)
+			if ((a.linked(x, y, DIR_EAST) != b.linked(x, y, DIR_EAST)) ||
+				(a.linked(x, y, DIR_NORTH) != b.linked(x, y, DIR_NORTH))) return false;
+	return true;
+}
+// same
+
+/*!
+	\brief A file name of its own in /tmp
+
+	Unique to the process and the call, such that test suites may
+	run at the same time. The caller removes the file.
+*/
+static std::string temp_name (const char *ext)
+{
+	static int n = 0;
+	char name[64];
+	snprintf(name, sizeof(name), "/tmp/testsim.%ld.%d%s", (long)getpid(), n++, ext);
+	return name;
+}
+// temp_name
+
+//! \brief Loads a maze into m, a failed check if it cannot be loaded
+static bool load (const std::string &path, Maze &m, int type)
+{
+	try {
+		m = Maze::load(path);
+		return true;
+	}
+	catch (const std::exception &e) {
+		printf("FAIL %s: %s (type %d)\n", path.c_str(), e.what(), type);
+		failures++;
+		return false;
+	}
+}
+// load
+
+//! \brief Loads the example mazes and round trips a large maze
+static void test_files (void)
+{
+	const char *posters[] = { "etc/whitemaze234.maze", "etc/graymaze128.maze", "etc/colormaze357.maze" };
+	std::string mzb = temp_name(".mzb");
+	std::string text_name = temp_name(".maze");
+	for (int i = 0; i < 3; i++) {
+		Maze m, back;
+		if (!load(posters[i], m, MAZE_WHITE + i)) continue;
+		check(m.type() == MAZE_WHITE + i, posters[i], m.type(), 0);
+		check((m.cols() == 6) && (m.rows() == 6), "poster size", m.type(), 0);
+		m.save(mzb);
+		if (load(mzb, back, m.type())) check(same(m, back), "binary round trip", m.type(), 0);
+	}
+	// a comb of 1000x1000 junctions
+	Maze big(MAZE_GRAY, 1000, 1000);
+	for (int x = 0; x < big.cols(); x++) {
+		if (x + 1 < big.cols()) big.link(x, 0, DIR_EAST);
+		for (int y = 0; y + 1 < big.rows(); y += (x % 3) + 1) big.link(x, y, DIR_NORTH);
+	}
+	big.set_start(0, 0, DIR_NORTH);
+	big.set_exit(999, 999, DIR_NORTH);
+	big.save(text_name);
+	big.save(mzb);
+	Maze text, bin;
+	if (load(text_name, text, MAZE_GRAY)) check(same(big, text), "text round trip", MAZE_GRAY, 0);
+	if (load(mzb, bin, MAZE_GRAY)) {
+		check(bin.mapped(), "binary maze is mapped", MAZE_GRAY, 0);
+		check(same(big, bin), "binary round trip", MAZE_GRAY, 0);
+	}
+	remove(text_name.c_str());
+	remove(mzb.c_str());
+}
+// test_files
+
+//! \brief Number of lines of a maze and number of junctions reachable from the start
+static long count (const Maze &m, long &reached)
+{
+	long lines = 0;
+	std::vector<char> seen((size_t)m.cols() * m.rows(), 0);
+	std::vector<int> todo(1, m.start_y() * m.cols() + m.start_x());
+	seen[todo[0]] = 1;
+	reached = 0;
+	while (!todo.empty()) {
+		int i = todo.back();
+		todo.pop_back();
+		reached++;
+		int x = i % m.cols(), y = i / m.cols();
+		for (int d = DIR_EAST; d <= DIR_SOUTH; d++) {
+			if (!m.linked(x, y, d)) continue;
+			if (d <= DIR_NORTH) lines++;
+			int j = (y + Maze::dy(d)) * m.cols() + x + Maze::dx(d);
+			if (!seen[j]) { seen[j] = 1; todo.push_back(j); }
+		}
+	}
+	return lines;
+}
+// count
+
+//! \brief Generates mazes and solves them
+static void test_generator (void)
+{
+	for (unsigned long long seed = 1; seed <= 8; seed++) {
+		Maze a = generate(MAZE_GRAY, 37, 23, seed, 0);
+		check(same(a, generate(MAZE_GRAY, 37, 23, seed, 0)), "generator deterministic", MAZE_GRAY, seed);
+		check(!same(a, generate(MAZE_GRAY, 37, 23, seed + 100, 0)), "generator depends on seed", MAZE_GRAY, seed);
+		long reached, lines = count(a, reached);
+		check(reached == 37 * 23, "perfect maze connected", MAZE_GRAY, seed);
+		check(lines == 37 * 23 - 1, "perfect maze is a tree", MAZE_GRAY, seed);
+		check(!a.contains(a.exit_x() + Maze::dx(a.exit_dir()), a.exit_y() + Maze::dy(a.exit_dir())),
+			"exit on the border", MAZE_GRAY, seed);
+		Maze b = generate(MAZE_GRAY, 37, 23, seed, 0.2);
+		check(count(b, reached) > lines, "looped maze has loops", MAZE_GRAY, seed);
+	}
+	for (int type = MAZE_WHITE; type <= MAZE_COLOR; type++) {
+		for (unsigned long long seed = 1; seed <= 2; seed++) {
+			Config cfg;
+			cfg.seed = seed;
+			Maze maze = generate(type, 5, 5, seed, (seed - 1) * 0.2);
+			Runtime rt(find_model(type), maze, cfg);
+			Result r = rt.run();
+			check(r.exited && !r.lost, "generated maze solved", type, seed);
+		}
+	}
+	Maze big = generate(MAZE_COLOR, 1000, 1000, 1, 0.1);
+	long reached, lines = count(big, reached);
+	check((big.cols() == 1000) && (big.rows() == 1000), "large maze", MAZE_COLOR, 1);
+	check(reached == 1000L * 1000, "large maze connected", MAZE_COLOR, 1);
+	check(lines > 1000L * 1000 - 1, "large maze has loops", MAZE_COLOR, 1);
+}
+// test_generator
+
+//! \brief Runs a small sweep with one and several threads
+static void test_batch (void)
+{
+	Maze maze = Maze::demo(MAZE_GRAY);
+	const int jobs = 12;
+	std::vector<Result> one(jobs), many(jobs);
+	for (int threads = 1; threads <= 4; threads += 3) {
+		std::vector<Result> &res = (threads == 1) ? one : many;
+		Pool pool(threads);
+		pool.run(jobs, [&](size_t job) {
+			Config cfg;
+			cfg.seed = job % 3 + 1;
+			cfg.params.value[PARAM_SPEED] = 40 + 10 * (int)(job / 3);
+			Runtime rt(find_model(maze.type()), maze, cfg);
+			res[job] = rt.run();
+		});
+	}
+	for (int j = 0; j < jobs; j++) {
+		check(one[j].params.value[PARAM_SPEED] == 40 + 10 * (j / 3), "speed applied", MAZE_GRAY, j % 3 + 1);
+		check(one[j].params.value[PARAM_TJUNC] != PARAM_KEEP, "compiled tjunc reported", MAZE_GRAY, j % 3 + 1);
+		check((one[j].t_end == many[j].t_end) && (one[j].distance == many[j].distance),
+			"batch independent of threads", MAZE_GRAY, j % 3 + 1);
+	}
+	check(one[0].t_exit != one[9].t_exit, "speed changes the run", MAZE_GRAY, 1);
+}
+// test_batch
+
+/*!
+	\brief Replays the shortest route
+
+	The robot is put back on the start after exploring. The second
+	run follows the mapped route, or the path without dead ends, and
+	must be faster than the first.
+*/
+static void test_replay (void)
+{
+	for (int type = MAZE_WHITE; type <= MAZE_COLOR; type++) {
+		Maze mazes[2] = { Maze::demo(type), generate(type, 7, 7, 7, 0.1) };
+		for (int i = 0; i < 2; i++)
+			for (int replay = 1; replay <= 2; replay++) {
+				Config cfg;
+				cfg.runs = 2;
+				cfg.params.value[PARAM_REPLAY] = replay;
+				Runtime rt(find_model(type), mazes[i], cfg);
+				Result r = rt.run();
+				check(r.runs == 2, (replay == 1) ? "map replay reaches the exit" : "path replay reaches the exit", type, i);
+				check(r.t_run[1] < r.t_run[0], (replay == 1) ? "map replay is faster" : "path replay is faster", type, i);
+			}
+	}
+}
+// test_replay
+
+/*!
+	\brief Learns routes in flash
+
+	Runs share the files of the brick, like a brick switched off and
+	on between them. The second run on a maze replays the learned
+	route and must be faster. A record cut off while appending must
+	not hide the routes before and after it. Set to replay the map,
+	the robot explores rather than replay the learned route.
+*/
+static void test_cache (void)
+{
+	for (int type = MAZE_WHITE; type <= MAZE_COLOR; type++) {
+		Maze mazes[2] = { generate(type, 7, 7, 1011, 0.1), generate(type, 10, 10, 1020, 0) };
+		Flash flash;
+		Result first[2];
+		Result learned[2];
+		for (int i = 0; i < 2; i++) {
+			Config cfg;
+			cfg.flash = &flash;
+			Runtime rt(find_model(type), mazes[i], cfg);
+			first[i] = rt.run();
+			check(first[i].exited, "exploring with learned routes", type, i);
+			check(flash.exists("routes.dat"), "route learned", type, i);
+			if (i == 0) {
+				// a record cut off after the header
+				unsigned int size;
+				int h;
+				check(flash.append("routes.dat", size, h) == LDR_SUCCESS, "append to routes", type, i);
+				for (int k = 0; k < 5; k++) flash.put(h, (k == 0) ? 0xA7 : (k == 4) ? 40 : type);
+				flash.close(h);
+			}
+		}
+		for (int i = 0; i < 2; i++) {
+			Config cfg;
+			cfg.seed = 2;
+			cfg.flash = &flash;
+			Runtime rt(find_model(type), mazes[i], cfg);
+			learned[i] = rt.run();
+			check(learned[i].exited, "learned route reaches the exit", type, i);
+			check(learned[i].t_exit < first[i].t_exit, "learned route is faster", type, i);
+		}
+		for (int i = 0; i < 2; i++) {
+			Config cfg;
+			cfg.flash = &flash;
+			cfg.params.value[PARAM_REPLAY] = 1;
+			Runtime rt(find_model(type), mazes[i], cfg);
+			Result r = rt.run();
+			check(r.exited, "exploring with replay=1", type, i);
+			check(r.t_exit > learned[i].t_exit, "replay=1 explores instead of the learned route", type, i);
+		}
+	}
+}
+// test_cache
+
+/*!
+	\brief Explores with the solvers of src/solver.h
+
+	The start is on a loop and the line to the exit leaves it to the
+	left, the right hand rule may circle forever. Tremaux and flood fill
+	must find the exit there, in a trap of the generator, which the
+	right hand rule does not get out of, and in a perfect maze.
+*/
+static void test_solver (void)
+{
+	for (int type = MAZE_WHITE; type <= MAZE_COLOR; type++) {
+		Maze island(type, 5, 5);
+		island.link(1, 1, DIR_NORTH);
+		island.link(1, 2, DIR_NORTH);
+		island.link(1, 3, DIR_EAST);
+		island.link(2, 3, DIR_EAST);
+		island.link(3, 3, DIR_SOUTH);
+		island.link(3, 2, DIR_SOUTH);
+		island.link(3, 1, DIR_WEST);
+		island.link(2, 1, DIR_WEST);
+		island.link(3, 2, DIR_EAST);
+		island.set_start(1, 1, DIR_NORTH);
+		island.set_exit(4, 2, DIR_EAST);
+		Maze mazes[3] = { island, trap(type, 7, 7, 1050), generate(type, 7, 7, 1010, 0) };
+		for (int i = 0; i < 3; i++)
+			for (int solver = 2; solver <= 3; solver++) {
+				Config cfg;
+				cfg.limit = 300000;
+				cfg.params.value[PARAM_SOLVER] = solver;
+				Runtime rt(find_model(type), mazes[i], cfg);
+				Result r = rt.run();
+				check(r.exited, (solver == 2) ? "tremaux reaches the exit" : "flood fill reaches the exit", type, i);
+			}
+		Config cfg;
+		cfg.limit = 300000;
+		Runtime rt(find_model(type), mazes[1], cfg);
+		check(!rt.run().exited, "right hand rule circles the trap", type, 1);
+	}
+}
+// test_solver
+
+//! \brief A junction of the naive grid, a bool per line and bit
+struct NaiveCell {
+	bool line[4];    //!< lines by direction, each line is kept at both ends
+	bool visited;    //!< visited
+	bool exit;       //!< exit strip
+};
+
+/*!
+	\brief Compares the packed grid of src/grid.h with a naive one
+
+	Random updates must give the same junctions in both. The packed
+	grid must fit 32x32 junctions in 512 bytes, a tenth of the naive
+	grid. Each of the 16 values of each junction must read back as
+	set without touching the junction sharing its byte. mazebench -g
+	compares the speed of the lookups.
+*/
+static void test_grid (void)
+{
+	const int cells = GRID_COLS * GRID_ROWS;
+	PackedGrid packed;
+	std::vector<NaiveCell> naive(cells);
+	for (int i = 0; i < cells; i++) naive[i] = NaiveCell();
+	Random rnd(9);
+	for (int k = 0; k < 100000; k++) {
+		int x = rnd.below(GRID_COLS), y = rnd.below(GRID_ROWS), op = rnd.below(6);
+		NaiveCell &c = naive[y * GRID_COLS + x];
+		if (op < 4) {
+			int nx = x + ((op == GRID_DIR_EAST) ? 1 : (op == GRID_DIR_WEST) ? -1 : 0);
+			int ny = y + ((op == GRID_DIR_NORTH) ? 1 : (op == GRID_DIR_SOUTH) ? -1 : 0);
+			bool on = packed.grid_contains(nx, ny);
+			check(packed.grid_link(x, y, op) == on, "grid link off the grid", 0, k);
+			if (on) {
+				c.line[op] = true;
+				naive[ny * GRID_COLS + nx].line[(op + 2) % 4] = true;
+			}
+		} else if (op == 4) {
+			int bits = (rnd.below(2) ? GRID_VISITED : 0) | (rnd.below(2) ? GRID_EXIT : 0);
+			packed.grid_set(x, y, bits);
+			c.visited = c.visited || (bits & GRID_VISITED);
+			c.exit = c.exit || (bits & GRID_EXIT);
+		} else {
+			packed.grid_clear(x, y, GRID_VISITED);
+			c.visited = false;
+		}
+	}
+	bool same = true;
+	for (int y = 0; y < GRID_ROWS; y++)
+		for (int x = 0; x < GRID_COLS; x++) {
+			const NaiveCell &c = naive[y * GRID_COLS + x];
+			int bits = packed.grid_get(x, y);
+			for (int d = 0; d < 4; d++) same = same && (packed.grid_line(x, y, d) == c.line[d]);
+			same = same && (((bits & GRID_VISITED) != 0) == c.visited) && (((bits & GRID_EXIT) != 0) == c.exit);
+		}
+	check(same, "packed grid equals naive grid", 0, 0);
+	check(sizeof(packed) == 512, "32x32 grid in 512 bytes", 0, sizeof(packed));
+	check(sizeof(packed) * 10 <= cells * sizeof(NaiveCell), "packed grid a tenth of the naive grid", 0, sizeof(packed));
+
+	// every value of every junction round trips, the other junction
+	// of its byte is kept
+	PackedGrid trip;
+	bool kept = true;
+	for (int i = 0; i < cells; i++) {
+		int x = i % GRID_COLS, y = i / GRID_COLS;
+		int j = i ^ 1, other = (i * 7) & 0x0F;
+		trip.grid_clear(j % GRID_COLS, j / GRID_COLS, 0x0F);
+		trip.grid_set(j % GRID_COLS, j / GRID_COLS, other);
+		for (int bits = 0; bits <= 0x0F; bits++) {
+			trip.grid_clear(x, y, 0x0F);
+			trip.grid_set(x, y, bits);
+			kept = kept && (trip.grid_get(x, y) == bits) && (trip.grid_get(j % GRID_COLS, j / GRID_COLS) == other);
+		}
+	}
+	check(kept, "bits of every junction round trip", 0, 0);
+}
+// test_grid
+
+/*!
+	\brief Latency of stops after a change of the surface
+
+	With the default sample period the robot stops within a few
+	samples of a new surface and odd samples at the edges of the
+	lines never make it search for the line. Sampling ten times less often makes
+	it stop later. With 3 percent of the samples reading the background
+	the surface falls back to undefined about as often as without,
+	the window drops the specks, and the confidence in the surface
+	drops by no more than the specks.
+*/
+static void test_observe (void)
+{
+	for (int type = MAZE_WHITE; type <= MAZE_COLOR; type++) {
+		Maze maze = Maze::demo(type);
+		Result r[3];
+		for (int i = 0; i < 3; i++) {
+			Config cfg;
+			cfg.params.value[PARAM_PERIOD] = (i == 1) ? 30 : 3;
+			cfg.glitch = (i == 2) ? 3 : 0;
+			Runtime rt(find_model(type), maze, cfg);
+			r[i] = rt.run();
+		}
+		check(r[0].exited && (r[0].stops > 0), "stops counted", type, 0);
+		check(r[0].entered[find_state(find_model(type), "ndef")] == 0, "no search for the line", type, 0);
+		check(r[0].t_stops < 15000LL * r[0].stops, "mean stop latency below 15 ms", type, 0);
+		check(r[1].stops && (r[1].t_stops / r[1].stops > r[0].t_stops / r[0].stops), "slower sampling stops later", type, 0);
+		check(r[2].exited && (r[2].entered[find_state(find_model(type), "ndef")] == 0), "no search for the line with specks", type, 0);
+		check(2 * r[2].undefined < 3 * r[0].undefined, "specks dropped by the window", type, r[2].undefined);
+		check(r[2].conf / r[2].samples + 3 >= r[0].conf / r[0].samples, "confidence drops with the specks only", type, 0);
+	}
+}
+// test_observe
+
+/*!
+	\brief Calibration at the start
+
+	The program of each maze type gets out of the demo maze of every
+	type. In a room 10 percent brighter or darker the calibrated
+	robot runs just like in normal light. Without calibration it
+	searches the line in the brighter room or does not get out.
+*/
+static void test_calibrate (void)
+{
+	for (int type = MAZE_WHITE; type <= MAZE_COLOR; type++) {
+		Maze maze = Maze::demo(type);
+		const int ndef = find_state(find_model(type), "ndef");
+		Config cfg;
+		Runtime ref(find_model(type), maze, cfg);
+		Result r = ref.run();
+		for (int other = MAZE_WHITE; other <= MAZE_COLOR; other++) {
+			Runtime rt(find_model(other), maze, cfg);
+			Result ro = rt.run();
+			check(ro.exited && (ro.t_exit == r.t_exit), "program of another type tells the poster", type, other);
+		}
+		for (int ambient = -10; ambient <= 10; ambient += 20) {
+			Config lit;
+			lit.ambient = ambient;
+			Runtime a(find_model(type), maze, lit);
+			Result ra = a.run();
+			check(ra.exited && (ra.t_exit == r.t_exit), "calibrated in ambient light", type, ambient + 100);
+		}
+		Config bright;
+		bright.ambient = 10;
+		bright.params.value[PARAM_CALIB] = 0;
+		Runtime b(find_model(type), maze, bright);
+		Result rb = b.run();
+		check(!rb.exited || (rb.entered[ndef] > 0), "not calibrated in ambient light", type, 110);
+	}
+}
+// test_calibrate
+
+/*!
+	\brief Pose by odometry
+
+	Exploring and replaying the demo maze, the pose the program
+	tracks stays within a quarter pitch of the true pose on average
+	and never gets half a pitch off, then it would be snapped to the
+	wrong junction.
+*/
+static void test_pose (void)
+{
+	for (int type = MAZE_WHITE; type <= MAZE_COLOR; type++) {
+		Maze maze = Maze::demo(type);
+		double p = maze.pitch(find_model(type).world);
+		Config cfg;
+		cfg.runs = 2;
+		Runtime rt(find_model(type), maze, cfg);
+		Result r = rt.run();
+		check((r.runs == 2) && (r.poses > 0), "poses compared", type, 0);
+		check(r.pose_error < r.poses * p / 4, "mean pose error below a quarter pitch", type, 0);
+		check(r.pose_error_max < p / 2, "pose error below half a pitch", type, 0);
+	}
+}
+// test_pose
+
+/*!
+	\brief Turns relative to the rotation counts
+
+	Exploring and replaying the demo maze, the robot turns on the
+	spot without ever resetting a rotation count.
+*/
+static void test_turn (void)
+{
+	for (int type = MAZE_WHITE; type <= MAZE_COLOR; type++) {
+		Maze maze = Maze::demo(type);
+		Config cfg;
+		cfg.runs = 2;
+		Runtime rt(find_model(type), maze, cfg);
+		Result r = rt.run();
+		check((r.runs == 2) && (r.turns > 0), "turned on the spot", type, 0);
+		check(r.resets == 0, "rotation counts never reset", type, 0);
+	}
+}
+// test_turn
+
+/*!
+	\brief Turns at junctions by the headings of the grid
+
+	Peeking at the headings of the grid rather than sweeping from
+	LOOK_SWEEP degrees right, exploring and replaying the demo maze
+	and a generated one, the robot turns less than 160 degrees per
+	look in each and less than 140 on average. Exploring by the
+	right hand rule, it turns a quarter turn right at least and a
+	full turn at a dead end, replaying it takes a line ahead without
+	turning.
+*/
+static void test_look (void)
+{
+	double rotation = 0;
+	int looks = 0;
+	for (int type = MAZE_WHITE; type <= MAZE_COLOR; type++) {
+		const int look = find_state(find_model(type), "look");
+		Maze mazes[2] = { Maze::demo(type), generate(type, 7, 7, 7, 0.1) };
+		for (int i = 0; i < 2; i++) {
+			Config cfg;
+			cfg.runs = 2;
+			cfg.params.value[PARAM_ROLL] = 0;
+			Runtime rt(find_model(type), mazes[i], cfg);
+			Result r = rt.run();
+			check(r.runs == 2, "explored and replayed", type, i);
+			check(r.r_state[look] < 160.0 * r.entered[look], "turns less than 160 degrees per look", type, i);
+			rotation += r.r_state[look];
+			looks += r.entered[look];
+		}
+	}
+	check(rotation < 140.0 * looks, "turns less than 140 degrees per look on average", 0, 0);
+}
+// test_look
+
+/*!
+	\brief Rolls through the junctions of a known way
+
+	Replaying the mapped route or the path, rolling through the
+	junctions must get to the exit and must not lose the line more
+	often than stopping at each. On the white mazes, which roll by
+	default, it must be faster. The lines of the gray and color
+	mazes are too short to roll the turns, rolling straight through
+	alone gains nothing there and they stop by default.
+*/
+static void test_roll (void)
+{
+	for (int type = MAZE_WHITE; type <= MAZE_COLOR; type++) {
+		const int ndef = find_state(find_model(type), "ndef");
+		Maze mazes[2] = { Maze::demo(type), generate(type, 7, 7, 7, 0.1) };
+		for (int i = 0; i < 2; i++)
+			for (int replay = 1; replay <= 2; replay++) {
+				long t[2];
+				int lost[2];
+				for (int roll = 0; roll <= 1; roll++) {
+					Config cfg;
+					cfg.runs = 2;
+					cfg.params.value[PARAM_REPLAY] = replay;
+					cfg.params.value[PARAM_ROLL] = roll;
+					Runtime rt(find_model(type), mazes[i], cfg);
+					Result r = rt.run();
+					check(r.runs == 2, "replay reaches the exit", type, i);
+					t[roll] = r.t_run[1];
+					lost[roll] = r.entered[ndef];
+				}
+				if (type == MAZE_WHITE) check(t[1] < t[0], "rolling replay is faster", type, i);
+				check(lost[1] <= lost[0], "rolling loses the line no more often", type, i);
+			}
+	}
+}
+// test_roll
+
+/*!
+	\brief Slows down before the junctions
+
+	With a ramp before the junctions the robot must still explore
+	and replay the demo maze of each type. It follows the lines
+	slower than without, so it spends longer in line.
+*/
+static void test_ramp (void)
+{
+	for (int type = MAZE_WHITE; type <= MAZE_COLOR; type++) {
+		const int line = find_state(find_model(type), "line");
+		Maze maze = Maze::demo(type);
+		Result r[2];
+		for (int k = 0; k < 2; k++) {
+			Config cfg;
+			cfg.runs = 2;
+			cfg.params.value[PARAM_RAMP] = 40 * k;
+			Runtime rt(find_model(type), maze, cfg);
+			r[k] = rt.run();
+		}
+		check(r[1].runs == 2, "explored and replayed with a ramp", type, 0);
+		check(r[1].t_state[line] > r[0].t_state[line], "the ramp slows down line", type, 0);
+	}
+}
+// test_ramp
+
+/*!
+	\brief Searches a lost line on its likely side first
+
+	Exploring and replaying a generated white maze with a weak line
+	follower, the robot loses the line now and then. It must find it
+	again in less than 600 ms on average, the doubling sweep alone
+	takes about a second.
+*/
+static void test_recover (void)
+{
+	const int type = MAZE_WHITE;
+	const int ndef = find_state(find_model(type), "ndef");
+	Maze maze = generate(type, 10, 10, 1020, 0.0);
+	int visits = 0;
+	long t_visits = 0;
+	for (unsigned long long seed = 1; seed <= 6; seed++) {
+		Config cfg;
+		cfg.seed = seed;
+		cfg.runs = 2;
+		cfg.params.value[PARAM_KP] = 140;
+		Runtime rt(find_model(type), maze, cfg);
+		Result r = rt.run();
+		check(r.visits[ndef] <= r.entered[ndef], "recoveries counted once", type, seed);
+		visits += r.visits[ndef];
+		t_visits += r.t_visits[ndef];
+	}
+	check(visits > 0, "the line is lost", type, 0);
+	check(t_visits < 600L * visits, "recovery takes less than 600 ms", type, 0);
+}
+// test_recover
+
+/*!
+	\brief Simulator test suite
+*/
+int main (void)
+{
+	test_files();
+	test_generator();
+	test_batch();
+	test_replay();
+	test_cache();
+	test_solver();
+	test_grid();
+	test_observe();
+	test_calibrate();
+	test_pose();
+	test_turn();
+	test_look();
+	test_roll();
+	test_ramp();
+	test_recover();
+	for (int type = MAZE_WHITE; type <= MAZE_COLOR; type++) {
+		Maze maze = Maze::demo(type);
+		for (unsigned long long seed = 1; seed <= 4; seed++) {
+			Config cfg;
+			cfg.seed = seed;
+			Runtime a(find_model(type), maze, cfg);
+			Result ra = a.run();
+			check(ra.exited, "exit reached", type, seed);
+			check(!ra.lost, "stays on the poster", type, seed);
+			check(ra.distance > 0 && ra.turns > 0, "robot moved", type, seed);
+			long sum = 0;
+			for (int i = 0; i < STATE_SLOTS; i++) sum += ra.t_state[i];
+			check((sum <= ra.t_end) && (sum + STATE_SLOTS >= ra.t_end), "state times add up", type, seed);
+			Runtime b(find_model(type), maze, cfg);
+			Result rb = b.run();
+			check((ra.t_end == rb.t_end) && (ra.distance == rb.distance), "deterministic", type, seed);
+		}
+	}
+	printf("%s\n", failures ? "FAILED" : "OK");
+	return failures ? 1 : 0;
+}
+// main